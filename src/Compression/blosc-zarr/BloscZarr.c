@@ -1,12 +1,192 @@
+#define _POSIX_C_SOURCE 199309L
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
 #include <blosc.h>
 
+/* Bytes of the input sampled by the auto mode trials */
+#define AUTO_SAMPLE_SIZE (1024 * 1024)
+/* Trials stop once they have taken this long in total */
+#define AUTO_MAX_SECONDS 0.5
+/* Each timing repeats its operation until this long has passed, well above
+ * the timer resolution, or up to AUTO_MAX_REPETITIONS times */
+#define AUTO_MIN_TIMING_SECONDS 0.01
+#define AUTO_MAX_REPETITIONS 100
+
+/* Monotonic wall clock in seconds. clock() only ticks every millisecond in
+ * browsers, and measures CPU time elsewhere. */
+static double now_seconds(void)
+{
+#ifdef __EMSCRIPTEN__
+  return emscripten_get_now() / 1000.0;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1.0e9;
+#endif
+}
+
+/* Throughput in MB/s of repetitions runs over size bytes. At least a
+ * microsecond is assumed, so speeds stay finite. */
+static double speed(size_t size, int repetitions, double start)
+{
+  double elapsed = now_seconds() - start;
+  if (elapsed < 1.0e-6)
+    {
+    elapsed = 1.0e-6;
+    }
+  return (double)size * repetitions / (1.0e6 * elapsed);
+}
+
+/* Try the candidate compressors, shuffle modes and levels on a sample of the
+ * input, each compressed and decompressed repeatedly for at least
+ * AUTO_MIN_TIMING_SECONDS, until AUTO_MAX_SECONDS have passed. Pick the best ratio among the settings that decompress at least at
+ * min_decompress_speed MB/s, or the fastest to decompress if none does.
+ * Returns 0 on success. */
+static int auto_tune(const char * compressor, const void * input_array, size_t input_size, size_t typesize,
+  double min_decompress_speed, const char ** best_compressor, int * best_clevel, int * best_shuffle)
+{
+  static const char * compressors[] = { "blosclz", "lz4", "lz4hc", "zlib", "zstd" };
+  static const int shuffles[] = { BLOSC_NOSHUFFLE, BLOSC_SHUFFLE, BLOSC_BITSHUFFLE };
+  static const int clevels[] = { 1, 5, 9 };
+  const int ncompressors = sizeof(compressors) / sizeof(compressors[0]);
+  const int nshuffles = sizeof(shuffles) / sizeof(shuffles[0]);
+  const int nclevels = sizeof(clevels) / sizeof(clevels[0]);
+
+  size_t sample_size = input_size < AUTO_SAMPLE_SIZE ? input_size : AUTO_SAMPLE_SIZE;
+  sample_size -= sample_size % typesize;
+  if (sample_size == 0)
+    {
+    sample_size = input_size;
+    }
+  void * compressed = malloc(sample_size + BLOSC_MAX_OVERHEAD);
+  void * decompressed = malloc(sample_size);
+  if (compressed == NULL || decompressed == NULL)
+    {
+    printf("Auto mode memory allocation failed");
+    free(compressed);
+    free(decompressed);
+    return 1;
+    }
+
+  const double tune_start = now_seconds();
+  int found = 0;
+  int best_meets_target = 0;
+  double best_ratio = 0.0;
+  double best_decompress_speed = 0.0;
+  for (int cc = 0; cc < ncompressors; cc++)
+    {
+    /* Restrict to the given compressor unless it is "auto" */
+    if (strcmp(compressor, "auto") != 0 && strcmp(compressor, compressors[cc]) != 0)
+      {
+      continue;
+      }
+    /* Skip codecs that were not built in */
+    if (blosc_set_compressor(compressors[cc]) < 0)
+      {
+      continue;
+      }
+    for (int ss = 0; ss < nshuffles; ss++)
+      {
+      for (int ll = 0; ll < nclevels; ll++)
+        {
+        /* Keep the best setting so far once out of time */
+        if (found && now_seconds() - tune_start >= AUTO_MAX_SECONDS)
+          {
+          break;
+          }
+        double start = now_seconds();
+        int compressed_size = 0;
+        int repetitions = 0;
+        do
+          {
+          compressed_size = blosc_compress(clevels[ll], shuffles[ss], typesize, sample_size, input_array,
+            compressed, sample_size + BLOSC_MAX_OVERHEAD);
+          repetitions++;
+          } while (compressed_size > 0 && repetitions < AUTO_MAX_REPETITIONS &&
+            now_seconds() - start < AUTO_MIN_TIMING_SECONDS);
+        if (compressed_size <= 0)
+          {
+          continue;
+          }
+        const double compress_speed = speed(sample_size, repetitions, start);
+
+        start = now_seconds();
+        int decompressed_size = 0;
+        repetitions = 0;
+        do
+          {
+          decompressed_size = blosc_decompress(compressed, decompressed, sample_size);
+          repetitions++;
+          } while (decompressed_size >= 0 && repetitions < AUTO_MAX_REPETITIONS &&
+            now_seconds() - start < AUTO_MIN_TIMING_SECONDS);
+        if (decompressed_size < 0)
+          {
+          continue;
+          }
+        const double decompress_speed = speed(sample_size, repetitions, start);
+        const double ratio = (1. * sample_size) / compressed_size;
+        printf("Trial: %s clevel %d shuffle %d: ratio %.2fx, compression %.1f MB/s, decompression %.1f MB/s\n",
+          compressors[cc], clevels[ll], shuffles[ss], ratio, compress_speed, decompress_speed);
+
+        const int meets_target = decompress_speed >= min_decompress_speed;
+        int better = 0;
+        if (!found)
+          {
+          better = 1;
+          }
+        else if (meets_target != best_meets_target)
+          {
+          better = meets_target;
+          }
+        else if (meets_target)
+          {
+          better = ratio > best_ratio;
+          }
+        else
+          {
+          better = decompress_speed > best_decompress_speed;
+          }
+        if (better)
+          {
+          found = 1;
+          best_meets_target = meets_target;
+          best_ratio = ratio;
+          best_decompress_speed = decompress_speed;
+          *best_compressor = compressors[cc];
+          *best_clevel = clevels[ll];
+          *best_shuffle = shuffles[ss];
+          }
+        }
+      }
+    }
+  free(compressed);
+  free(decompressed);
+
+  if (!found)
+    {
+    printf("Auto mode found no usable compressor for: %s\n", compressor);
+    return 1;
+    }
+  printf("Auto: %s clevel %d shuffle %d: ratio %.2fx, decompression %.1f MB/s\n",
+    *best_compressor, *best_clevel, *best_shuffle, best_ratio, best_decompress_speed);
+  return 0;
+}
+
 int main(int argc, char * argv[]){
   if (argc < 6)
     {
-    printf("Usage: %s <input_array_file> <output_array_file> <compressor> <input_size> <output_size> [clevel] [csize] [typesize] [shuffle]", argv[0]);
+    printf("Usage: %s <input_array_file> <output_array_file> <compressor> <input_size> <output_size> [clevel] [typesize] [shuffle] [min_decompress_speed] [auto_settings_file]\n", argv[0]);
     printf("If clevel (compression level) argument supplied, compression is applied to the input binary file.\n");
     printf("Otherwise, decompression is applied to the input binary file.\n");
+    printf("If clevel is auto, the compressor (or all compressors, if it is auto), shuffle and clevel are chosen by\n");
+    printf("trials on a sample of the input: the best ratio that decompresses at min_decompress_speed MB/s or faster.\n");
+    printf("Auto mode requires typesize. The chosen \"compressor clevel shuffle\" are written to auto_settings_file,\n");
+    printf("if given, to pass as the compressor, clevel and shuffle arguments for the following chunks of the array.\n");
     return 1;
     }
   const char * input_filename = argv[1];
@@ -16,20 +196,43 @@ int main(int argc, char * argv[]){
   const size_t output_size = atoi(argv[5]);
   // 0 to 9
   int clevel = -1;
+  int auto_mode = 0;
   size_t typesize = 1;
   int shuffle = 1;
+  double min_decompress_speed = 0.0;
+  const char * auto_settings_filename = NULL;
   if (argc > 6)
     {
-    clevel = atoi(argv[6]);
+    auto_mode = strcmp(argv[6], "auto") == 0;
+    clevel = auto_mode ? 0 : atoi(argv[6]);
+    }
+  if (auto_mode && argc < 8)
+    {
+    printf("Auto mode requires the typesize argument.\n");
+    return 1;
     }
   if (argc > 7)
     {
-    typesize = atoi(argv[7]);
+    const int typesize_argument = atoi(argv[7]);
+    if (typesize_argument < 1)
+      {
+      printf("Invalid typesize: %s\n", argv[7]);
+      return 1;
+      }
+    typesize = typesize_argument;
     }
   if (argc > 8)
     {
     shuffle = atoi(argv[8]);
     }
+  if (argc > 9)
+    {
+    min_decompress_speed = atof(argv[9]);
+    }
+  if (argc > 10)
+    {
+    auto_settings_filename = argv[10];
+    }
 
 
   /* Register the filter with the library */
@@ -42,7 +245,7 @@ int main(int argc, char * argv[]){
   const int pnthreads = blosc_set_nthreads(nthreads);
   // printf("Using %d threads (previously using %d)\n", nthreads, pnthreads);
 
-  int rcode = blosc_set_compressor(compressor);
+  int rcode = auto_mode ? 0 : blosc_set_compressor(compressor);
   if (rcode < 0)
     {
     printf("Error setting %s compressor. Does it really exist?", compressor);
@@ -85,6 +288,32 @@ int main(int argc, char * argv[]){
     return 1;
     }
 
+  if (auto_mode)
+    {
+    if (auto_tune(compressor, input_array, input_size, typesize, min_decompress_speed, &compressor, &clevel, &shuffle))
+      {
+      blosc_destroy();
+      free(input_array);
+      free(output_array);
+      return 1;
+      }
+    blosc_set_compressor(compressor);
+    if (auto_settings_filename != NULL)
+      {
+      FILE * auto_settings_file = fopen(auto_settings_filename, "w");
+      if (auto_settings_file == NULL)
+        {
+        printf("Error opening auto settings file: %s\n", auto_settings_filename);
+        blosc_destroy();
+        free(input_array);
+        free(output_array);
+        return 1;
+        }
+      fprintf(auto_settings_file, "%s %d %d\n", compressor, clevel, shuffle);
+      fclose(auto_settings_file);
+      }
+    }
+
   if (clevel >= 0)
     {
     printf("Compression level %d", clevel);
@@ -36,6 +36,9 @@ class ViewerMachineContext {
       if (typeof config.uiCollapsed !== 'undefined') {
         this.uiCollapsed = config.uiCollapsed
       }
+      if (typeof config.quantizeCoarseScales !== 'undefined') {
+        this.quantizeCoarseScales = config.quantizeCoarseScales
+      }
 
       this.main = new MainMachineContext(config.main)
     } else {
@@ -55,6 +58,7 @@ class ViewerMachineContext {
       xyLowerLeft: this.xyLowerLeft,
       containerStyle: { ...this.containerStyle },
       uiCollapsed: this.uiCollapsed,
+      quantizeCoarseScales: this.quantizeCoarseScales,
 
       main: this.main.getConfig(),
     }
@@ -92,6 +96,10 @@ class ViewerMachineContext {
   // rendering?
   uiCollapsed = false
 
+  // Are the coarser scales of float images stored quantized to 16 bits?
+  // Lossy, but they take a half or a quarter of the memory.
+  quantizeCoarseScales = false
+
   // Main machine context
   main = null
 
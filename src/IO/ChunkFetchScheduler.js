@@ -0,0 +1,102 @@
+import axios from 'axios'
+
+const cores = navigator.hardwareConcurrency ? navigator.hardwareConcurrency : 4
+
+/*
+ * Runs chunk requests, fetch and decode, with a bounded number in flight.
+ *
+ * Queued requests are started in priority order, lowest first, and can be
+ * cancelled before or while they run. Cancelled requests reject with an
+ * error for which axios.isCancel() is true.
+ */
+class ChunkFetchScheduler {
+  constructor(maxInFlight = 2 * cores) {
+    this.maxInFlight = maxInFlight
+    // Sorted on dispatch with the next request to start last
+    this.queue = []
+    this.sorted = true
+    this.dispatchPending = false
+    this.inFlight = new Set()
+    this.sequence = 0
+  }
+
+  /* run: function(cancelToken) that returns a Promise for the chunk.
+   * priority: function that returns the current priority, lower first.
+   * tags: Object identifying the request for cancel(). */
+  schedule(run, priority, tags) {
+    return new Promise((resolve, reject) => {
+      const request = {
+        run,
+        priority,
+        tags,
+        resolve,
+        reject,
+        key: priority(),
+        sequence: this.sequence++,
+        cancelSource: null,
+      }
+      this.queue.push(request)
+      this.sorted = false
+      // Requests scheduled together are sorted once
+      if (!this.dispatchPending) {
+        this.dispatchPending = true
+        Promise.resolve().then(() => {
+          this.dispatchPending = false
+          this.dispatch()
+        })
+      }
+    })
+  }
+
+  /* Re-evaluate the priority of the queued requests, e.g. after the
+   * slice position changed. */
+  reprioritize() {
+    this.queue.forEach(request => {
+      request.key = request.priority()
+    })
+    this.sorted = false
+  }
+
+  /* Cancel the queued and in flight requests whose tags match the
+   * predicate. */
+  cancel(predicate) {
+    const remaining = []
+    this.queue.forEach(request => {
+      if (predicate(request.tags)) {
+        request.reject(new axios.Cancel('Stale chunk request'))
+      } else {
+        remaining.push(request)
+      }
+    })
+    this.queue = remaining
+    this.inFlight.forEach(request => {
+      if (predicate(request.tags)) {
+        request.cancelSource.cancel('Stale chunk request')
+      }
+    })
+  }
+
+  dispatch() {
+    if (!this.sorted) {
+      this.queue.sort((a, b) => b.key - a.key || b.sequence - a.sequence)
+      this.sorted = true
+    }
+    while (this.inFlight.size < this.maxInFlight && this.queue.length > 0) {
+      const request = this.queue.pop()
+      request.cancelSource = axios.CancelToken.source()
+      this.inFlight.add(request)
+      request
+        .run(request.cancelSource.token)
+        .then(request.resolve, request.reject)
+        .finally(() => {
+          this.inFlight.delete(request)
+          this.dispatch()
+        })
+    }
+  }
+}
+
+// Shared by all images so the cap applies to the whole viewer
+export const chunkFetchScheduler = new ChunkFetchScheduler()
+
+export default ChunkFetchScheduler
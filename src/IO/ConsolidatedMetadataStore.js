@@ -18,7 +18,8 @@ class ConsolidatedMetadataStore {
     this.zmetadata = metadata
   }
 
-  async getItem(item) {
+  /* cancelToken: optional axios CancelToken for chunk requests */
+  async getItem(item, cancelToken) {
     if (
       item.includes('.zattrs') ||
       item.includes('.zgroup') ||
@@ -32,6 +33,7 @@ class ConsolidatedMetadataStore {
       const chunkUrl = `${this.url.href}/${item}`
       const response = await axios.get(chunkUrl, {
         responseType: 'arraybuffer',
+        cancelToken,
       })
       const data = response.data
       return data
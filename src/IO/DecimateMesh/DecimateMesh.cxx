@@ -0,0 +1,209 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMeshFileReader.h"
+#include "itkMeshFileWriter.h"
+#if defined(__EMSCRIPTEN__)
+#include "itkJSONMeshIO.h"
+#else
+#include "itkMeshIOFactory.h"
+#endif
+#include "itkQuadEdgeMesh.h"
+#include "itkQuadEdgeMeshDecimationCriteria.h"
+#include "itkQuadricDecimationQuadEdgeMeshFilter.h"
+#include "itkNumericTraits.h"
+
+// Quadric decimation that never collapses an edge with an end point below
+// the number of locked points. Chunks of a mesh lock the points they share
+// with their neighbors, so the decimated chunks still meet along the seams.
+template < typename TMesh, typename TCriterion >
+class SeamPreservingQuadricDecimation
+  : public itk::QuadricDecimationQuadEdgeMeshFilter< TMesh, TMesh, TCriterion >
+{
+public:
+  using Self = SeamPreservingQuadricDecimation;
+  using Superclass = itk::QuadricDecimationQuadEdgeMeshFilter< TMesh, TMesh, TCriterion >;
+  using Pointer = itk::SmartPointer< Self >;
+  itkNewMacro( Self );
+
+  using OutputQEType = typename Superclass::OutputQEType;
+  using MeasureType = typename Superclass::MeasureType;
+  using PointIdentifier = typename TMesh::PointIdentifier;
+
+  void
+  SetNumberOfLockedPoints( PointIdentifier numberOfLockedPoints )
+  {
+    m_NumberOfLockedPoints = numberOfLockedPoints;
+  }
+
+protected:
+  SeamPreservingQuadricDecimation() = default;
+
+  MeasureType
+  MeasureEdge( OutputQEType * iEdge ) override
+  {
+    if ( iEdge->GetOrigin() < m_NumberOfLockedPoints || iEdge->GetDestination() < m_NumberOfLockedPoints )
+    {
+      return itk::NumericTraits< MeasureType >::max();
+    }
+    return Superclass::MeasureEdge( iEdge );
+  }
+
+private:
+  PointIdentifier m_NumberOfLockedPoints{ 0 };
+};
+
+// Satisfied at the target number of faces, or once only edges with a locked
+// end point are left to collapse
+template < typename TMesh >
+class NumberOfFacesOrLockedCriterion : public itk::NumberOfFacesCriterion< TMesh >
+{
+public:
+  using Self = NumberOfFacesOrLockedCriterion;
+  using Superclass = itk::NumberOfFacesCriterion< TMesh >;
+  using Pointer = itk::SmartPointer< Self >;
+  itkNewMacro( Self );
+
+  using MeshType = typename Superclass::MeshType;
+  using ElementType = typename Superclass::ElementType;
+  using MeasureType = typename Superclass::MeasureType;
+
+  bool
+  is_satisfied( MeshType * iMesh, const ElementType & iElement, const MeasureType & iValue ) const override
+  {
+    return iValue >= itk::NumericTraits< MeasureType >::max() || Superclass::is_satisfied( iMesh, iElement, iValue );
+  }
+
+protected:
+  NumberOfFacesOrLockedCriterion() = default;
+};
+
+template < typename TMesh >
+int
+DecimateMesh( char * argv [] )
+{
+  using MeshType = TMesh;
+  const char * inputMeshFile = argv[1];
+  const char * outputMeshFile = argv[2];
+  const unsigned int numberOfFaces = atoi( argv[3] );
+  // The first points of the input are kept in place, with their identifiers
+  const unsigned int numberOfLockedPoints = argv[4] ? atoi( argv[4] ) : 0;
+
+  using ReaderType = itk::MeshFileReader< MeshType >;
+  auto reader = ReaderType::New();
+  reader->SetFileName( inputMeshFile );
+
+  try
+  {
+    reader->Update();
+  }
+  catch( std::exception & error )
+  {
+    std::cerr << "Error: " << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  using WriterType = itk::MeshFileWriter< MeshType >;
+  auto writer = WriterType::New();
+  writer->SetFileName( outputMeshFile );
+
+  // Nothing to collapse: pass the input through so every level of detail
+  // request produces an output.
+  if ( reader->GetOutput()->GetNumberOfFaces() <= numberOfFaces )
+  {
+    writer->SetInput( reader->GetOutput() );
+  }
+  else
+  {
+    using CriterionType = NumberOfFacesOrLockedCriterion< MeshType >;
+    auto criterion = CriterionType::New();
+    criterion->SetTopologicalChange( false );
+    criterion->SetNumberOfElements( numberOfFaces );
+
+    using DecimationType = SeamPreservingQuadricDecimation< MeshType, CriterionType >;
+    auto decimate = DecimationType::New();
+    decimate->SetInput( reader->GetOutput() );
+    decimate->SetCriterion( criterion );
+    decimate->SetNumberOfLockedPoints( numberOfLockedPoints );
+    try
+    {
+      decimate->Update();
+    }
+    catch( std::exception & error )
+    {
+      std::cerr << "Error: " << error.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    // Fill the identifiers of the removed points from the end, so the output
+    // buffers are contiguous. The locked points are never removed and keep
+    // their identifiers.
+    decimate->GetOutput()->SqueezePointsIds();
+    writer->SetInput( decimate->GetOutput() );
+  }
+
+  try
+  {
+    writer->Update();
+  }
+  catch( std::exception & error )
+  {
+    std::cerr << "Error: " << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main( int argc, char * argv[] )
+{
+  if( argc < 4 || argc > 5 )
+    {
+    std::cerr << "Usage: " << argv[0] << " <inputMesh> <outputMesh> <numberOfFaces> [numberOfLockedPoints]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char * inputMeshFile = argv[1];
+
+#if defined(__EMSCRIPTEN__)
+  itk::JSONMeshIO::Pointer meshIO = itk::JSONMeshIO::New();
+#else
+  itk::MeshIOBase::Pointer meshIO = itk::MeshIOFactory::CreateMeshIO( inputMeshFile, itk::CommonEnums::IOFileMode::ReadMode );
+#endif
+  if ( meshIO.IsNull() )
+    {
+    std::cerr << "Unable to read mesh: " << inputMeshFile << std::endl;
+    return EXIT_FAILURE;
+    }
+  meshIO->SetFileName( inputMeshFile );
+  meshIO->ReadMeshInformation();
+
+  // Quadric decimation operates on triangulated surfaces; point data is
+  // carried through as scalars and is not used by the collapse cost.
+  const unsigned int pointDimension = meshIO->GetPointDimension();
+  switch (pointDimension)
+  {
+  case 3:
+    {
+    using MeshType = itk::QuadEdgeMesh< float, 3 >;
+    return DecimateMesh< MeshType >( argv );
+    }
+  default:
+    std::cerr << "Dimension not implemented!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
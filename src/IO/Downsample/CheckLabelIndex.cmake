@@ -0,0 +1,60 @@
+# Check the content of a label index written by Downsample.
+#
+#   cmake -DLABEL_INDEX=<labelIndex.json> -DTOTAL_COUNT=<voxels>
+#     [-DLABELS=<label>;...] -P CheckLabelIndex.cmake
+#
+# The counts of all the labels must add up to TOTAL_COUNT. For each of LABELS,
+# LABEL_<label>_count, LABEL_<label>_bboxMin, LABEL_<label>_bboxMax and
+# LABEL_<label>_chunks, the number of chunks, are compared with its entry.
+cmake_minimum_required(VERSION 3.19)
+
+file(READ "${LABEL_INDEX}" labelIndex)
+
+function(get_json output)
+  string(JSON value ERROR_VARIABLE error GET "${labelIndex}" ${ARGN})
+  if(error)
+    message(FATAL_ERROR "${LABEL_INDEX}: ${error}")
+  endif()
+  set(${output} "${value}" PARENT_SCOPE)
+endfunction()
+
+function(get_json_index output)
+  string(JSON length LENGTH "${labelIndex}" ${ARGN})
+  math(EXPR last "${length} - 1")
+  set(index)
+  foreach(dim RANGE ${last})
+    get_json(component ${ARGN} ${dim})
+    list(APPEND index ${component})
+  endforeach()
+  set(${output} "${index}" PARENT_SCOPE)
+endfunction()
+
+string(JSON numberOfLabels LENGTH "${labelIndex}")
+if(numberOfLabels EQUAL 0)
+  message(FATAL_ERROR "${LABEL_INDEX}: no labels")
+endif()
+math(EXPR lastLabel "${numberOfLabels} - 1")
+set(totalCount 0)
+foreach(labelIndexEntry RANGE ${lastLabel})
+  string(JSON label MEMBER "${labelIndex}" ${labelIndexEntry})
+  get_json(count ${label} count)
+  math(EXPR totalCount "${totalCount} + ${count}")
+endforeach()
+if(NOT totalCount EQUAL TOTAL_COUNT)
+  message(FATAL_ERROR
+    "${LABEL_INDEX}: ${totalCount} labeled voxels, expected ${TOTAL_COUNT}")
+endif()
+
+foreach(label ${LABELS})
+  get_json(count ${label} count)
+  get_json_index(bboxMin ${label} bboxMin)
+  get_json_index(bboxMax ${label} bboxMax)
+  string(JSON chunks LENGTH "${labelIndex}" ${label} chunks)
+  foreach(property count bboxMin bboxMax chunks)
+    set(expected "${LABEL_${label}_${property}}")
+    if(NOT "${${property}}" STREQUAL "${expected}")
+      message(FATAL_ERROR "${LABEL_INDEX}: label ${label} ${property} is "
+        "${${property}}, expected ${expected}")
+    endif()
+  endforeach()
+endforeach()
@@ -0,0 +1,21 @@
+# Check the quantization written by Downsample.
+#
+#   cmake -DQUANTIZATION=<quantization.txt> -DOFFSET=<offset> -DSCALE=<scale>
+#     -DOUTPUT_IMAGE=<output.mha> -DELEMENT_TYPE=<MET_USHORT>
+#     -P CheckQuantization.cmake
+#
+# The offset and scale are written with 17 significant digits, so they are
+# compared as strings. The MetaImage header of the output gives its component
+# type.
+file(READ "${QUANTIZATION}" quantization)
+string(STRIP "${quantization}" quantization)
+if(NOT quantization STREQUAL "${OFFSET} ${SCALE}")
+  message(FATAL_ERROR
+    "${QUANTIZATION}: offset and scale are ${quantization}, expected ${OFFSET} ${SCALE}")
+endif()
+
+file(STRINGS "${OUTPUT_IMAGE}" elementType REGEX "^ElementType = " LIMIT_COUNT 1)
+if(NOT elementType STREQUAL "ElementType = ${ELEMENT_TYPE}")
+  message(FATAL_ERROR
+    "${OUTPUT_IMAGE}: ${elementType}, expected ${ELEMENT_TYPE}")
+endif()
@@ -19,6 +19,7 @@
 #include "itkImageFileWriter.h"
 #if defined(__EMSCRIPTEN__)
 #include "itkJSONImageIO.h"
+#include <emscripten.h>
 #endif
 #include "itkBinShrinkImageFilter.h"
 #include "itkVectorImage.h"
@@ -41,7 +42,185 @@
 #include "itkMatrix.h"
 #include "itkVariableLengthVector.h"
 #include "itkVariableSizeMatrix.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkUnaryGeneratorImageFilter.h"
+#include "itkCommand.h"
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <unordered_map>
+
+// Component type families to instantiate. Each family can be built as a
+// separate, smaller module; by default every family is built.
+#if !defined(DOWNSAMPLE_UNSIGNED_INTEGERS) && !defined(DOWNSAMPLE_SIGNED_INTEGERS) && !defined(DOWNSAMPLE_FLOATS)
+#define DOWNSAMPLE_UNSIGNED_INTEGERS
+#define DOWNSAMPLE_SIGNED_INTEGERS
+#define DOWNSAMPLE_FLOATS
+#endif
+
+// Report the progress of a filter in whole percent. In the browser, the
+// pipeline runs to completion before its worker returns, so the progress is
+// posted to the main thread as a downsampleProgress event with the fraction
+// done.
+class ProgressObserver : public itk::Command
+{
+public:
+  using Self = ProgressObserver;
+  using Superclass = itk::Command;
+  using Pointer = itk::SmartPointer< Self >;
+  itkNewMacro( Self );
+
+  void
+  Execute( itk::Object * caller, const itk::EventObject & event ) override
+  {
+    this->Execute( const_cast< const itk::Object * >( caller ), event );
+  }
+
+  void
+  Execute( const itk::Object * caller, const itk::EventObject & event ) override
+  {
+    auto process = dynamic_cast< const itk::ProcessObject * >( caller );
+    if ( !process || !itk::ProgressEvent().CheckEvent( &event ) )
+    {
+      return;
+    }
+    const int percent = static_cast< int >( 100.0f * process->GetProgress() );
+    if ( percent == m_LastPercent )
+    {
+      return;
+    }
+    m_LastPercent = percent;
+#if defined(__EMSCRIPTEN__)
+    EM_ASM( { postMessage( { eventName: 'downsampleProgress', args: [$0 / 100] } ); }, percent );
+#else
+    std::cout << "Progress: " << percent << "%" << std::endl;
+#endif
+  }
+
+protected:
+  ProgressObserver() = default;
+
+private:
+  int m_LastPercent{ -1 };
+};
+
+// Write, for every label in the region of the image, its voxel count,
+// bounding box, and the chunks that contain it, as JSON.
+template < typename TImage >
+void
+WriteLabelIndex( const TImage * image, const typename TImage::RegionType & region,
+  const typename TImage::SizeType & chunkSize, const char * labelIndexFile )
+{
+  using ImageType = TImage;
+  using PixelType = typename ImageType::PixelType;
+  using IndexType = typename ImageType::IndexType;
+  using RegionType = typename ImageType::RegionType;
+  constexpr unsigned int Dimension = ImageType::ImageDimension;
+
+  struct LabelEntry
+  {
+    size_t count = 0;
+    IndexType min;
+    IndexType max;
+    std::vector< IndexType > chunks;
+  };
+  std::unordered_map< PixelType, LabelEntry > labelEntries;
+
+  IndexType chunkStart;
+  IndexType chunkEnd;
+  for ( unsigned int dim = 0; dim < Dimension; ++dim )
+  {
+    chunkStart[dim] = region.GetIndex()[dim] / chunkSize[dim];
+    chunkEnd[dim] = ( region.GetUpperIndex()[dim] ) / chunkSize[dim];
+  }
+
+  // Visit the region chunk by chunk so each label records a chunk once
+  IndexType chunk = chunkStart;
+  bool moreChunks = true;
+  while ( moreChunks )
+  {
+    RegionType chunkRegion;
+    for ( unsigned int dim = 0; dim < Dimension; ++dim )
+    {
+      chunkRegion.SetIndex( dim, chunk[dim] * chunkSize[dim] );
+      chunkRegion.SetSize( dim, chunkSize[dim] );
+    }
+    chunkRegion.Crop( region );
+
+    LabelEntry * entry = nullptr;
+    PixelType previousLabel{};
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it( image, chunkRegion );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+      const PixelType label = it.Get();
+      const IndexType & index = it.GetIndex();
+      if ( entry == nullptr || label != previousLabel )
+      {
+        previousLabel = label;
+        entry = &labelEntries[label];
+        if ( entry->count == 0 )
+        {
+          entry->min = index;
+          entry->max = index;
+        }
+        if ( entry->chunks.empty() || entry->chunks.back() != chunk )
+        {
+          entry->chunks.push_back( chunk );
+        }
+      }
+      ++entry->count;
+      for ( unsigned int dim = 0; dim < Dimension; ++dim )
+      {
+        entry->min[dim] = std::min( entry->min[dim], index[dim] );
+        entry->max[dim] = std::max( entry->max[dim], index[dim] );
+      }
+    }
+
+    moreChunks = false;
+    for ( unsigned int dim = 0; dim < Dimension; ++dim )
+    {
+      if ( chunk[dim] < chunkEnd[dim] )
+      {
+        ++chunk[dim];
+        moreChunks = true;
+        break;
+      }
+      chunk[dim] = chunkStart[dim];
+    }
+  }
+
+  const auto writeIndex = []( std::ofstream & ostream, const IndexType & index ) {
+    ostream << "[";
+    for ( unsigned int dim = 0; dim < Dimension; ++dim )
+    {
+      ostream << ( dim ? "," : "" ) << index[dim];
+    }
+    ostream << "]";
+  };
+  std::ofstream ostream( labelIndexFile );
+  ostream << "{";
+  bool firstLabel = true;
+  for ( const auto & labelEntry : labelEntries )
+  {
+    const LabelEntry & entry = labelEntry.second;
+    ostream << ( firstLabel ? "" : "," ) << "\"" << static_cast< long long >( labelEntry.first ) << "\":{";
+    firstLabel = false;
+    ostream << "\"count\":" << entry.count << ",\"bboxMin\":";
+    writeIndex( ostream, entry.min );
+    ostream << ",\"bboxMax\":";
+    writeIndex( ostream, entry.max );
+    ostream << ",\"chunks\":[";
+    for ( size_t chunkIndex = 0; chunkIndex < entry.chunks.size(); ++chunkIndex )
+    {
+      ostream << ( chunkIndex ? "," : "" );
+      writeIndex( ostream, entry.chunks[chunkIndex] );
+    }
+    ostream << "]}";
+  }
+  ostream << "}";
+  ostream.close();
+}
 
 template < typename TImage >
 int
@@ -57,6 +236,17 @@ LabelImageDownsample( char * argv [] )
   unsigned int maxTotalSplits = atoi( argv[7] );
   unsigned int split = atoi( argv[8] );
   const char * numberOfSplitsFile = argv[9];
+  // Optional label index outputs, argv is terminated by a null pointer. The
+  // optional input label index covers the input voxels that map to this
+  // split, so the splits of a pass also index the finer scale.
+  const char * labelIndexFile = argv[10];
+  typename ImageType::SizeType chunkSize;
+  chunkSize.Fill( 64 );
+  for ( unsigned int dim = 0; labelIndexFile && dim < ImageType::ImageDimension; ++dim )
+  {
+    chunkSize[dim] = atoi( argv[11 + dim] );
+  }
+  const char * inputLabelIndexFile = labelIndexFile ? argv[14] : nullptr;
 
   using ReaderType = itk::ImageFileReader< ImageType >;
   auto reader = ReaderType::New();
@@ -70,6 +260,7 @@ LabelImageDownsample( char * argv [] )
   if (ImageType::ImageDimension > 2) {
     filter->SetShrinkFactor( 2, factorK );
   }
+  const bool identity = factorI == 1 && factorJ == 1 && (ImageType::ImageDimension == 2 || factorK == 1);
 
   using WriterType = itk::ImageFileWriter< ImageType >;
   auto writer = WriterType::New();
@@ -78,6 +269,7 @@ LabelImageDownsample( char * argv [] )
   using ResampleFilterType = itk::ResampleImageFilter< ImageType, ImageType >;
   auto resampleFilter = ResampleFilterType::New();
   resampleFilter->SetInput( reader->GetOutput() );
+  resampleFilter->AddObserver( itk::ProgressEvent(), ProgressObserver::New() );
 
   filter->UpdateOutputInformation();
   using ROIFilterType = itk::ExtractImageFilter< ImageType, ImageType >;
@@ -105,7 +297,16 @@ LabelImageDownsample( char * argv [] )
   roiFilter->SetExtractionRegion( requestedRegion );
   writer->SetInput( roiFilter->GetOutput() );
 
-  roiFilter->SetInput( resampleFilter->GetOutput() );
+  // Unit factors pass the labels through unchanged, e.g. to index the
+  // highest resolution
+  if ( identity )
+  {
+    roiFilter->SetInput( reader->GetOutput() );
+  }
+  else
+  {
+    roiFilter->SetInput( resampleFilter->GetOutput() );
+  }
   const ImageType * shrunk = filter->GetOutput();
   resampleFilter->SetSize( shrunk->GetLargestPossibleRegion().GetSize() );
   resampleFilter->SetOutputOrigin( shrunk->GetOrigin() );
@@ -130,6 +331,38 @@ LabelImageDownsample( char * argv [] )
   try
   {
     writer->Update();
+    if ( labelIndexFile )
+    {
+      const ImageType * output = roiFilter->GetOutput();
+      WriteLabelIndex< ImageType >( output, output->GetBufferedRegion(), chunkSize, labelIndexFile );
+    }
+    if ( inputLabelIndexFile )
+    {
+      // Input voxels binned into the split's output voxels. The last split
+      // along a dimension also takes the input remainder that BinShrink
+      // drops.
+      const unsigned int factors[3] = { factorI, factorJ, factorK };
+      const RegionType inputLargestRegion( reader->GetOutput()->GetLargestPossibleRegion() );
+      RegionType inputRegion;
+      for ( unsigned int dim = 0; dim < ImageType::ImageDimension; ++dim )
+      {
+        const itk::IndexValueType factor = factors[dim];
+        const itk::IndexValueType start = inputLargestRegion.GetIndex( dim ) +
+          ( requestedRegion.GetIndex( dim ) - largestRegion.GetIndex( dim ) ) * factor;
+        itk::IndexValueType upper = inputLargestRegion.GetIndex( dim ) +
+          ( requestedRegion.GetUpperIndex()[dim] - largestRegion.GetIndex( dim ) + 1 ) * factor - 1;
+        if ( requestedRegion.GetUpperIndex()[dim] == largestRegion.GetUpperIndex()[dim] )
+        {
+          upper = inputLargestRegion.GetUpperIndex()[dim];
+        }
+        inputRegion.SetIndex( dim, start );
+        inputRegion.SetSize( dim, upper - start + 1 );
+      }
+      // No-op when the resampling already buffered the region
+      reader->GetOutput()->SetRequestedRegion( inputRegion );
+      reader->GetOutput()->Update();
+      WriteLabelIndex< ImageType >( reader->GetOutput(), inputRegion, chunkSize, inputLabelIndexFile );
+    }
   }
   catch( std::exception & error )
   {
@@ -203,6 +436,7 @@ Downsample( char * argv [] )
   writer->SetInput( roiFilter->GetOutput() );
 
   roiFilter->SetInput( filter->GetOutput() );
+  filter->AddObserver( itk::ProgressEvent(), ProgressObserver::New() );
 
   try
   {
@@ -217,6 +451,122 @@ Downsample( char * argv [] )
   return EXIT_SUCCESS;
 }
 
+// Downsample a floating point scalar image into TQuantizedPixel. The finite
+// input range is mapped onto the full quantized range; value = offset + q *
+// scale, with the offset and scale written to the quantization file.
+template < typename TImage, typename TQuantizedPixel >
+int
+QuantizedDownsample( char * argv [] )
+{
+  using ImageType = TImage;
+  using QuantizedImageType = itk::Image< TQuantizedPixel, ImageType::ImageDimension >;
+  const char * inputImageFile = argv[2];
+  const char * outputImageFile = argv[3];
+  unsigned int factorI = atoi( argv[4] );
+  unsigned int factorJ = atoi( argv[5] );
+  unsigned int factorK = atoi( argv[6] );
+  unsigned int maxTotalSplits = atoi( argv[7] );
+  unsigned int split = atoi( argv[8] );
+  const char * numberOfSplitsFile = argv[9];
+  const char * quantizationFile = argv[11];
+
+  using ReaderType = itk::ImageFileReader< ImageType >;
+  auto reader = ReaderType::New();
+  reader->SetFileName( inputImageFile );
+
+  using FilterType = itk::BinShrinkImageFilter< ImageType, ImageType >;
+  auto filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetShrinkFactor( 0, factorI );
+  filter->SetShrinkFactor( 1, factorJ );
+  if (ImageType::ImageDimension > 2) {
+    filter->SetShrinkFactor( 2, factorK );
+  }
+
+  using WriterType = itk::ImageFileWriter< QuantizedImageType >;
+  auto writer = WriterType::New();
+  writer->SetFileName( outputImageFile );
+
+  filter->UpdateOutputInformation();
+  using ROIFilterType = itk::ExtractImageFilter< ImageType, ImageType >;
+  auto roiFilter = ROIFilterType::New();
+  using RegionType = typename ImageType::RegionType;
+  const RegionType largestRegion( filter->GetOutput()->GetLargestPossibleRegion() );
+
+  using SplitterType = itk::ImageRegionSplitterSlowDimension;
+  auto splitter = SplitterType::New();
+  const unsigned int numberOfSplits = splitter->GetNumberOfSplits( largestRegion, maxTotalSplits );
+
+  std::ofstream ostream(numberOfSplitsFile);
+  ostream << numberOfSplits;
+  ostream.close();
+
+  if (split >= numberOfSplits)
+  {
+    split = 0;
+  }
+
+  RegionType requestedRegion( largestRegion );
+  splitter->GetSplit( split, numberOfSplits, requestedRegion );
+  roiFilter->SetExtractionRegion( requestedRegion );
+  roiFilter->SetInput( filter->GetOutput() );
+  filter->AddObserver( itk::ProgressEvent(), ProgressObserver::New() );
+
+  try
+  {
+    // Every split reads the entire input, so they all agree on its range.
+    // Only finite values set the range.
+    reader->Update();
+    double minimum = itk::NumericTraits< double >::max();
+    double maximum = itk::NumericTraits< double >::NonpositiveMin();
+    itk::ImageRegionConstIterator< ImageType > it( reader->GetOutput(), reader->GetOutput()->GetBufferedRegion() );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+      const double value = it.Get();
+      if ( std::isfinite( value ) )
+      {
+        minimum = std::min( minimum, value );
+        maximum = std::max( maximum, value );
+      }
+    }
+    const double quantizedMaximum = itk::NumericTraits< TQuantizedPixel >::max();
+    const double offset = minimum <= maximum ? minimum : 0.0;
+    double scale = ( maximum - offset ) / quantizedMaximum;
+    if ( !( scale > 0.0 ) )
+    {
+      scale = 1.0;
+    }
+
+    // Round to the nearest step. NaN maps to 0, -Inf and +Inf clamp to the
+    // ends of the quantized range.
+    using QuantizeFilterType = itk::UnaryGeneratorImageFilter< ImageType, QuantizedImageType >;
+    auto quantize = QuantizeFilterType::New();
+    quantize->SetInput( roiFilter->GetOutput() );
+    quantize->SetFunctor( [offset, scale, quantizedMaximum]( const typename ImageType::PixelType & value ) {
+      if ( std::isnan( static_cast< double >( value ) ) )
+      {
+        return TQuantizedPixel{ 0 };
+      }
+      const double step = std::floor( ( value - offset ) / scale + 0.5 );
+      return static_cast< TQuantizedPixel >( std::min( std::max( step, 0.0 ), quantizedMaximum ) );
+    } );
+    writer->SetInput( quantize->GetOutput() );
+    writer->Update();
+
+    std::ofstream qstream( quantizationFile );
+    qstream.precision( 17 );
+    qstream << offset << " " << scale;
+    qstream.close();
+  }
+  catch( std::exception & error )
+  {
+    std::cerr << "Error: " << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
 template <typename TComponent, unsigned int VDimension>
 int
 PixelTypeDownsample( const itk::IOPixelEnum pixelType, char * argv[] )
@@ -466,6 +816,21 @@ PixelTypeDownsampleFloats( const itk::IOPixelEnum pixelType, char * argv[] )
     {
       using PixelType = ComponentType;
       using ImageType = itk::Image<PixelType, VDimension>;
+      // Optional quantized output, argv is terminated by a null pointer
+      const char * quantizedComponentType = argv[10];
+      if (quantizedComponentType && argv[11])
+      {
+        if (std::string(quantizedComponentType) == "uint8")
+        {
+          return QuantizedDownsample<ImageType, unsigned char>( argv );
+        }
+        if (std::string(quantizedComponentType) == "uint16")
+        {
+          return QuantizedDownsample<ImageType, unsigned short>( argv );
+        }
+        std::cerr << "Unsupported quantized component type: " << quantizedComponentType << std::endl;
+        return EXIT_FAILURE;
+      }
       return Downsample<ImageType>( argv );
     }
     //case itk::IOPixelEnum::RGB:
@@ -603,42 +968,55 @@ ComponentTypeDownsample( const itk::IOPixelEnum pixelType, const itk::IOComponen
 {
   switch (componentType)
   {
+#if defined(DOWNSAMPLE_UNSIGNED_INTEGERS)
     case itk::IOComponentEnum::UCHAR:
     {
       using ComponentType = unsigned char;
       return PixelTypeDownsampleUIntegers<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_SIGNED_INTEGERS)
     case itk::IOComponentEnum::CHAR:
     {
       using ComponentType = char;
       return PixelTypeDownsampleScalar<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_UNSIGNED_INTEGERS)
     case itk::IOComponentEnum::USHORT:
     {
       using ComponentType = unsigned short;
       return PixelTypeDownsampleUIntegers<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_SIGNED_INTEGERS)
     case itk::IOComponentEnum::SHORT:
     {
       using ComponentType = short;
       return PixelTypeDownsampleScalar<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_UNSIGNED_INTEGERS)
     case itk::IOComponentEnum::UINT:
     {
       using ComponentType = unsigned int;
       return PixelTypeDownsampleUIntegers<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_SIGNED_INTEGERS)
     case itk::IOComponentEnum::INT:
     {
       using ComponentType = int;
       return PixelTypeDownsampleScalar<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_UNSIGNED_INTEGERS)
     case itk::IOComponentEnum::ULONG:
     {
       // JS does not have broad support for 64-bit ints
@@ -646,7 +1024,9 @@ ComponentTypeDownsample( const itk::IOPixelEnum pixelType, const itk::IOComponen
       using ComponentType = unsigned int;
       return PixelTypeDownsampleUIntegers<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_SIGNED_INTEGERS)
     case itk::IOComponentEnum::LONG:
     {
       // JS does not have broad support for 64-bit ints
@@ -654,18 +1034,23 @@ ComponentTypeDownsample( const itk::IOPixelEnum pixelType, const itk::IOComponen
       using ComponentType = int;
       return PixelTypeDownsampleScalar<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_FLOATS)
     case itk::IOComponentEnum::FLOAT:
     {
       using ComponentType = float;
       return PixelTypeDownsampleFloats<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
+#if defined(DOWNSAMPLE_FLOATS)
     case itk::IOComponentEnum::DOUBLE:
     {
       using ComponentType = double;
       return PixelTypeDownsampleFloats<ComponentType, VDimension>( pixelType, argv );
     }
+#endif
 
     case itk::IOComponentEnum::UNKNOWNCOMPONENTTYPE:
     default:
@@ -680,7 +1065,7 @@ int main( int argc, char * argv[] )
 {
   if( argc < 10 )
     {
-    std::cerr << "Usage: " << argv[0] << " <isLabelImage> <inputImage> <outputImage> <factorI> <factorJ> <factorK> <maxTotalSplits> <split> <numberOfSplitsFile>" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <isLabelImage> <inputImage> <outputImage> <factorI> <factorJ> <factorK> <maxTotalSplits> <split> <numberOfSplitsFile> [<labelIndexFile> <chunkI> <chunkJ> <chunkK> [<inputLabelIndexFile>] | <quantizedComponentType> <quantizationFile>]" << std::endl;
     return EXIT_FAILURE;
     }
   const char * inputImageFile = argv[2];
@@ -701,6 +1086,16 @@ int main( int argc, char * argv[] )
 
   const unsigned int imageDimension = imageIO->GetNumberOfDimensions();
 
+  // Optional arguments come in complete groups
+  const unsigned int isLabelImage = atoi( argv[1] );
+  if ( argc > 10 && argc < ( isLabelImage ? 14 : 12 ) )
+    {
+    std::cerr << "Error: incomplete "
+              << ( isLabelImage ? "label index" : "quantization" )
+              << " arguments" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   switch (imageDimension)
   {
   case 2:
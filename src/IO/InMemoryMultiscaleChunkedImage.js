@@ -5,12 +5,17 @@ import WebworkerPromise from 'webworker-promise'
 import ChuckerWorker from './Chunker.worker'
 
 import WorkerPool from 'itk/WorkerPool'
+import IntTypes from 'itk/IntTypes'
+import FloatTypes from 'itk/FloatTypes'
 import runPipelineBrowser from 'itk/runPipelineBrowser'
+import createWebworkerPromise from 'itk/createWebworkerPromise'
 import Image from 'itk/Image'
 import IOTypes from 'itk/IOTypes'
 import imageSharedBufferOrCopy from 'itk/imageSharedBufferOrCopy'
 import stackImages from 'itk/stackImages'
 
+import pipelineAvailable from './pipelineAvailable'
+
 const createChunkerWorker = existingWorker => {
   if (existingWorker) {
     const webworkerPromise = new WebworkerPromise(existingWorker)
@@ -30,8 +35,72 @@ const createChunk = async (webWorker, args) => {
 const numberOfWorkers = navigator.hardwareConcurrency
   ? navigator.hardwareConcurrency
   : 6
+
+// WorkerPool task function. A wasm pipeline runs synchronously in its
+// worker, so a split of a cancelled build is stopped by terminating its
+// worker. A split that is cancelled or fails resolves without a worker, with
+// its error if any, and the pool creates a new worker for its next task.
+// progressCallback is called with the fraction of the split done, from the
+// downsampleProgress events the pipeline posts while it runs.
+const runDownsamplePipeline = async (
+  webWorker,
+  pipelinePath,
+  args,
+  desiredOutputs,
+  inputs,
+  cancelToken,
+  progressCallback
+) => {
+  const { worker } = await createWebworkerPromise('Pipeline', webWorker)
+  if (!!cancelToken && !!cancelToken.reason) {
+    return { webWorker: worker }
+  }
+  const progressListener = event => {
+    if (!!event.data && event.data.eventName === 'downsampleProgress') {
+      progressCallback(event.data.args[0])
+    }
+  }
+  if (!!progressCallback) {
+    worker.addEventListener('message', progressListener)
+  }
+  let running = true
+  const pipeline = runPipelineBrowser(
+    worker,
+    pipelinePath,
+    args,
+    desiredOutputs,
+    inputs
+  ).then(
+    result => {
+      running = false
+      if (!!progressCallback) {
+        worker.removeEventListener('message', progressListener)
+        progressCallback(1)
+      }
+      return result
+    },
+    error => {
+      running = false
+      worker.terminate()
+      return { webWorker: null, error }
+    }
+  )
+  if (!!!cancelToken) {
+    return pipeline
+  }
+  const cancelled = cancelToken.promise.then(() => {
+    if (running) {
+      worker.terminate()
+    }
+    return { webWorker: null }
+  })
+  return Promise.race([pipeline, cancelled])
+}
 //const chunkerWorkerPool = new WorkerPool(numberOfWorkers, createChunk)
-const downsampleWorkerPool = new WorkerPool(numberOfWorkers, runPipelineBrowser)
+const downsampleWorkerPool = new WorkerPool(
+  numberOfWorkers,
+  runDownsamplePipeline
+)
 
 class Coords {
   constructor(image, dims) {
@@ -68,9 +137,9 @@ class Coords {
   }
 }
 
-function chunkImage(image, chunkSize) {
+// Chunk grid layout of an image; only the image metadata is required
+function chunkImageInfo(image, chunkSize) {
   const imageType = image.imageType
-  const componentType = imageType.componentType
 
   const dims = []
   const sizeCXYZTChunks = [1, chunkSize[0], chunkSize[1], 1, 1]
@@ -105,6 +174,43 @@ function chunkImage(image, chunkSize) {
     numberOfCXYZTChunks[1] *
     numberOfCXYZTChunks[2] *
     numberOfCXYZTChunks[3]
+
+  const coords = new Coords(image, dims)
+  const scaleInfo = {
+    dims,
+    coords,
+    numberOfCXYZTChunks,
+    sizeCXYZTChunks,
+    sizeCXYZTElements,
+  }
+
+  return { scaleInfo, chunksStride }
+}
+
+// Image direction as a nested Array indexed by the position of the dims, the
+// layout of the direction attribute of Zarr scales
+function dimsDirection(direction, dims) {
+  const result = dims.map((rowDim, row) =>
+    dims.map((columnDim, column) => (row === column ? 1.0 : 0.0))
+  )
+  const spatialDims = ['x', 'y', 'z']
+  for (let d1 = 0; d1 < direction.rows; d1++) {
+    const row = dims.indexOf(spatialDims[d1])
+    for (let d2 = 0; d2 < direction.columns; d2++) {
+      const column = dims.indexOf(spatialDims[d2])
+      // Matrix data is row major; pipeline outputs are plain objects
+      result[row][column] = direction.data[d1 * direction.columns + d2]
+    }
+  }
+  return result
+}
+
+function chunkImage(image, chunkSize) {
+  const imageType = image.imageType
+  const componentType = imageType.componentType
+  const { scaleInfo, chunksStride } = chunkImageInfo(image, chunkSize)
+  const { numberOfCXYZTChunks, sizeCXYZTChunks } = scaleInfo
+
   let chunks = new Array(
     numberOfCXYZTChunks[0] *
       numberOfCXYZTChunks[1] *
@@ -136,7 +242,10 @@ function chunkImage(image, chunkSize) {
   let offset = 0
   const cxElements = sizeCXYZTChunks[0] * sizeCXYZTChunks[1]
 
-  const singleChunk = numberOfCXYZTChunks.every(e => e === 1)
+  // Chunks must be laid out with the chunk strides, so the data can only be
+  // used as-is when it spans exactly one chunk
+  const singleChunk =
+    numberOfCXYZTChunks.every(e => e === 1) && data.length === chunkElements
   if (singleChunk) {
     chunks[0] = data
   } else {
@@ -196,23 +305,275 @@ function chunkImage(image, chunkSize) {
     //}
   }
 
-  const coords = new Coords(image, dims)
-  const scaleInfo = {
-    dims,
-    coords,
-    numberOfCXYZTChunks,
-    sizeCXYZTChunks,
-    sizeCXYZTElements,
+  return { scaleInfo, chunksStride, chunks }
+}
+
+// Downsample pipeline argument for each supported quantized component type
+const quantizedComponentTypeArgs = new Map([
+  [IntTypes.UInt8, 'uint8'],
+  [IntTypes.UInt16, 'uint16'],
+])
+
+// Map quantized values back to the original component type,
+// value = offset + q * scale
+function dequantize(data, quantization, arrayType) {
+  const { offset, scale } = quantization
+  const result = new arrayType(data.length)
+  for (let i = 0; i < data.length; i++) {
+    result[i] = offset + data[i] * scale
   }
+  return result
+}
 
-  return { scaleInfo, chunksStride, chunks }
+// Downsample is built as one pipeline per component type family, so only the
+// family of the image is fetched and compiled. Until the family modules are
+// deployed with the viewer, the all-family Downsample pipeline is used.
+const downsampleFallbackPipeline = 'Downsample'
+const downsamplePipelines = new Map([
+  [IntTypes.UInt8, 'DownsampleUInt'],
+  [IntTypes.UInt16, 'DownsampleUInt'],
+  [IntTypes.UInt32, 'DownsampleUInt'],
+  [IntTypes.UInt64, 'DownsampleUInt'],
+  [IntTypes.Int8, 'DownsampleInt'],
+  [IntTypes.Int16, 'DownsampleInt'],
+  [IntTypes.Int32, 'DownsampleInt'],
+  [IntTypes.Int64, 'DownsampleInt'],
+  [FloatTypes.Float32, 'DownsampleFloat'],
+  [FloatTypes.Float64, 'DownsampleFloat'],
+])
+
+async function downsamplePipeline(componentType) {
+  const familyPipeline = downsamplePipelines.get(componentType)
+  if (!!familyPipeline && (await pipelineAvailable(familyPipeline))) {
+    return familyPipeline
+  }
+  return downsampleFallbackPipeline
+}
+
+function downsampleFactors(size, chunkSize) {
+  return size.map((s, i) => {
+    const n = Math.ceil(s / 2)
+    const factor = n >= chunkSize[i] ? 2 : 1
+    return factor
+  })
+}
+
+// Number of downsample passes buildPyramid runs, to report its progress
+function numberOfDownsamplePasses(size, chunkSize) {
+  let passes = 0
+  let currentSize = size
+  while (currentSize.reduce((a, c, i) => a || c / chunkSize[i] >= 2.0, false)) {
+    const factors = downsampleFactors(currentSize, chunkSize)
+    currentSize = currentSize.map((s, i) => Math.floor(s / factors[i]))
+    passes++
+  }
+  return passes
+}
+
+// Whether the deployed Downsample pipelines write the label index and the
+// quantized output. Modules built before them, like the shipped
+// DownsampleWasm, do not.
+let labelIndexSupported = true
+let quantizationSupported = true
+
+// With labelIndexChunkSize, label images also output the index of the labels
+// in their split, and with indexInput, in the input voxels that map to their
+// split. With quantizedComponentType, float scalar images are output
+// quantized along with their offset and scale.
+function downsampleTask(
+  pipelinePath,
+  image,
+  factors,
+  isLabelImage,
+  maxTotalSplits,
+  split,
+  labelIndexChunkSize = null,
+  indexInput = false,
+  quantizedComponentType = null
+) {
+  const data = imageSharedBufferOrCopy(image)
+  const inputs = [
+    {
+      path: 'input.json',
+      type: IOTypes.Image,
+      data: data,
+    },
+  ]
+  const desiredOutputs = [
+    { path: 'output.json', type: IOTypes.Image },
+    { path: 'numberOfSplits.txt', type: IOTypes.Text },
+  ]
+  const args = [
+    isLabelImage ? '1' : '0',
+    'input.json',
+    'output.json',
+    factors[0].toString(),
+    factors[1].toString(),
+    factors.length > 2 ? factors[2].toString() : '1',
+    '' + maxTotalSplits,
+    '' + split,
+    'numberOfSplits.txt',
+  ]
+  if (isLabelImage && !!labelIndexChunkSize) {
+    args.push(
+      'labelIndex.json',
+      labelIndexChunkSize[0].toString(),
+      labelIndexChunkSize[1].toString(),
+      labelIndexChunkSize.length > 2 ? labelIndexChunkSize[2].toString() : '1'
+    )
+    desiredOutputs.push({ path: 'labelIndex.json', type: IOTypes.Text })
+    if (indexInput) {
+      args.push('inputLabelIndex.json')
+      desiredOutputs.push({ path: 'inputLabelIndex.json', type: IOTypes.Text })
+    }
+  } else if (!isLabelImage && !!quantizedComponentType) {
+    args.push(
+      quantizedComponentTypeArgs.get(quantizedComponentType),
+      'quantization.txt'
+    )
+    desiredOutputs.push({ path: 'quantization.txt', type: IOTypes.Text })
+  }
+  return [pipelinePath, args, desiredOutputs, inputs]
+}
+
+// With a cancelToken, the running splits are terminated and the queued ones
+// dropped once it is cancelled, and the returned Promise rejects with the
+// axios.Cancel. progressCallback(completedSplits, totalSplits) is called as
+// the splits progress; completedSplits sums the fractions done of every
+// split.
+async function runDownsampleTasks(
+  image,
+  factors,
+  isLabelImage,
+  maxTotalSplits,
+  labelIndexChunkSize = null,
+  indexInput = false,
+  quantizedComponentType = null,
+  cancelToken = null,
+  progressCallback = null
+) {
+  const splitsProgress = new Array(maxTotalSplits).fill(0)
+  const splitProgressCallback = split =>
+    !!progressCallback
+      ? fraction => {
+          splitsProgress[split] = fraction
+          progressCallback(
+            splitsProgress.reduce((a, c) => a + c, 0),
+            maxTotalSplits
+          )
+        }
+      : null
+  const pipelinePath = await downsamplePipeline(image.imageType.componentType)
+  const downsampleTaskArgs = []
+  for (let index = 0; index < maxTotalSplits; index++) {
+    downsampleTaskArgs.push(
+      downsampleTask(
+        pipelinePath,
+        image,
+        factors,
+        isLabelImage,
+        maxTotalSplits,
+        index,
+        labelIndexChunkSize,
+        indexInput,
+        quantizedComponentType
+      ).concat([cancelToken, splitProgressCallback(index)])
+    )
+  }
+  const { promise, runId } = downsampleWorkerPool.runTasks(downsampleTaskArgs)
+  if (!!cancelToken) {
+    cancelToken.promise.then(() => {
+      downsampleWorkerPool.cancel(runId)
+    })
+  }
+  let results = null
+  try {
+    results = await promise
+  } catch (error) {
+    if (!!cancelToken) {
+      cancelToken.throwIfRequested()
+    }
+    throw error
+  }
+  if (!!cancelToken) {
+    cancelToken.throwIfRequested()
+  }
+  const failed = results.find(r => !!r.error)
+  if (!!failed) {
+    throw failed.error
+  }
+  return results.filter((r, i) => parseInt(r.outputs[1].data) > i)
+}
+
+/* Merge the label indices of the splits of a scale, in the given output of
+ * the split results, into a Map of
+ *
+ *   label => {
+ *     count, // number of voxels
+ *     bboxMin: [i, j, k], // inclusive bounding box, in voxels
+ *     bboxMax: [i, j, k],
+ *     chunks: [[i, j, k], ...], // spatial indices of the chunks with the label
+ *   }
+ */
+function mergeLabelIndices(splitResults, outputIndex = 2) {
+  const labelIndex = new Map()
+  const labelChunkKeys = new Map()
+  splitResults.forEach(({ outputs }) => {
+    const splitIndex = JSON.parse(outputs[outputIndex].data)
+    Object.keys(splitIndex).forEach(key => {
+      const label = Number(key)
+      const splitEntry = splitIndex[key]
+      if (!labelIndex.has(label)) {
+        labelIndex.set(label, {
+          count: 0,
+          bboxMin: splitEntry.bboxMin.slice(),
+          bboxMax: splitEntry.bboxMax.slice(),
+          chunks: [],
+        })
+        labelChunkKeys.set(label, new Set())
+      }
+      const entry = labelIndex.get(label)
+      entry.count += splitEntry.count
+      for (let d = 0; d < entry.bboxMin.length; d++) {
+        entry.bboxMin[d] = Math.min(entry.bboxMin[d], splitEntry.bboxMin[d])
+        entry.bboxMax[d] = Math.max(entry.bboxMax[d], splitEntry.bboxMax[d])
+      }
+      // Splits may share a chunk along their boundary
+      const chunkKeys = labelChunkKeys.get(label)
+      splitEntry.chunks.forEach(chunk => {
+        const chunkKey = chunk.join(',')
+        if (!chunkKeys.has(chunkKey)) {
+          chunkKeys.add(chunkKey)
+          entry.chunks.push(chunk)
+        }
+      })
+    })
+  })
+  return labelIndex
 }
 
 class InMemoryMultiscaleChunkedImage extends MultiscaleChunkedImage {
+  /* quantization: for float scalar images, e.g.
+   *
+   *   { componentType: IntTypes.UInt16, fromScale: 1 }
+   *
+   * stores the scales from fromScale on with the given integer component
+   * type. The offset and scale are chosen from the range of the first
+   * quantized scale's input and are shared by the coarser scales. Scales
+   * before fromScale, and always scale 0, are kept exact.
+   *
+   * cancelToken: an axios CancelToken to stop building the pyramid of an
+   * image that is no longer wanted.
+   *
+   * progressCallback: called with { loaded, total } as the downsample splits
+   * progress, in units of downsample passes. */
   static async buildPyramid(
     image,
     chunkSize = [64, 64, 64],
-    isLabelImage = false
+    isLabelImage = false,
+    quantization = null,
+    cancelToken = null,
+    progressCallback = null
   ) {
     const scale0 = chunkImage(image, chunkSize)
     const scaleInfo = [scale0.scaleInfo]
@@ -226,50 +587,114 @@ class InMemoryMultiscaleChunkedImage extends MultiscaleChunkedImage {
 
     let currentImage = image
     const maxTotalSplits = parseInt(numberOfWorkers * 1.0)
-    const pipelinePath = 'Downsample'
+    let labelIndexChunkSize =
+      isLabelImage && labelIndexSupported ? chunkSize : null
+    const componentType = image.imageType.componentType
+    let quantize =
+      quantizationSupported &&
+      !isLabelImage &&
+      !!quantization &&
+      quantizedComponentTypeArgs.has(quantization.componentType) &&
+      image.imageType.components === 1 &&
+      (componentType === FloatTypes.Float32 ||
+        componentType === FloatTypes.Float64)
+    let levelQuantization = null
+
+    const numberOfPasses = Math.max(
+      numberOfDownsamplePasses(image.size, chunkSize),
+      1
+    )
+    let completedPasses = 0
+    const passProgressCallback = !!progressCallback
+      ? (completedSplits, totalSplits) => {
+          progressCallback({
+            loaded: Math.min(
+              completedPasses + completedSplits / totalSplits,
+              numberOfPasses
+            ),
+            total: numberOfPasses,
+          })
+        }
+      : null
+    // A pass that fails with the label index or quantized output is run
+    // again without them, and if that succeeds the pyramid goes without them
+    const downsamplePass = async (
+      passImage,
+      factors,
+      splits,
+      indexInput = false,
+      quantizedComponentType = null
+    ) => {
+      const run = (indexChunkSize, outputComponentType) =>
+        runDownsampleTasks(
+          passImage,
+          factors,
+          isLabelImage,
+          splits,
+          indexChunkSize,
+          indexInput,
+          outputComponentType,
+          cancelToken,
+          passProgressCallback
+        )
+      if (!!!labelIndexChunkSize && !!!quantizedComponentType) {
+        return run(null, null)
+      }
+      try {
+        return await run(labelIndexChunkSize, quantizedComponentType)
+      } catch (error) {
+        if (!!cancelToken && !!cancelToken.reason) {
+          throw error
+        }
+        const results = await run(null, null)
+        if (!!labelIndexChunkSize) {
+          console.warn('Downsample does not write the label index', error)
+          labelIndexSupported = false
+          labelIndexChunkSize = null
+          pyramid.forEach(level => {
+            level.labelIndex = null
+          })
+        } else {
+          console.warn('Downsample does not quantize', error)
+          quantizationSupported = false
+          quantize = false
+        }
+        return results
+      }
+    }
     while (
       currentImage.size.reduce((a, c, i) => a || c / chunkSize[i] >= 2.0, false)
     ) {
-      const factors = currentImage.size.map((s, i) => {
-        const n = Math.ceil(s / 2)
-        const factor = n >= chunkSize[i] ? 2 : 1
-        return factor
-      })
+      const factors = downsampleFactors(currentImage.size, chunkSize)
 
-      const downsampleTaskArgs = []
-      for (let index = 0; index < maxTotalSplits; index++) {
-        const data = imageSharedBufferOrCopy(currentImage)
-        const inputs = [
-          {
-            path: 'input.json',
-            type: IOTypes.Image,
-            data: data,
-          },
-        ]
-        const desiredOutputs = [
-          { path: 'output.json', type: IOTypes.Image },
-          { path: 'numberOfSplits.txt', type: IOTypes.Text },
-        ]
-        const args = [
-          isLabelImage ? '1' : '0',
-          'input.json',
-          'output.json',
-          factors[0].toString(),
-          factors[1].toString(),
-          factors.length > 2 ? factors[2].toString() : '1',
-          '' + maxTotalSplits,
-          '' + index,
-          'numberOfSplits.txt',
-        ]
-        downsampleTaskArgs.push([pipelinePath, args, desiredOutputs, inputs])
-      }
-      const results = await downsampleWorkerPool.runTasks(downsampleTaskArgs)
-        .promise
-      const validResults = results.filter(
-        (r, i) => parseInt(r.outputs[1].data) > i
+      // Once quantized, the coarser scales are downsampled from the
+      // quantized image
+      const quantizeLevel =
+        quantize &&
+        !levelQuantization &&
+        pyramid.length >= Math.max(quantization.fromScale, 1)
+      // The first pass also indexes its input, the highest resolution
+      const validResults = await downsamplePass(
+        currentImage,
+        factors,
+        maxTotalSplits,
+        pyramid.length === 1,
+        quantizeLevel ? quantization.componentType : null
       )
+      completedPasses++
       const imageSplits = validResults.map(({ outputs }) => outputs[0].data)
       currentImage = stackImages(imageSplits)
+      if (quantizeLevel && quantize) {
+        const [offset, scale] = validResults[0].outputs[2].data
+          .trim()
+          .split(' ')
+          .map(parseFloat)
+        levelQuantization = { offset, scale }
+      }
+
+      if (!!labelIndexChunkSize && pyramid.length === 1) {
+        pyramid[0].labelIndex = mergeLabelIndices(validResults, 3)
+      }
 
       const scaleN = chunkImage(currentImage, chunkSize)
       scaleInfo.push(scaleN.scaleInfo)
@@ -277,14 +702,133 @@ class InMemoryMultiscaleChunkedImage extends MultiscaleChunkedImage {
         chunksStride: scaleN.chunksStride,
         chunks: scaleN.chunks,
         largestImage: currentImage,
+        labelIndex: !!labelIndexChunkSize
+          ? mergeLabelIndices(validResults)
+          : null,
+        quantization: levelQuantization,
       })
     }
 
+    if (!!labelIndexChunkSize && pyramid.length === 1) {
+      // A single scale: unit factors index it without resampling
+      const unitFactors = image.size.map(() => 1)
+      const indexResults = await downsamplePass(image, unitFactors, 1)
+      if (!!labelIndexChunkSize) {
+        pyramid[0].labelIndex = mergeLabelIndices(indexResults)
+      }
+    }
+
     // scale
     const imageType = image.imageType
     return { scaleInfo, imageType, pyramid }
   }
 
+  /* Build the pyramid from consecutive slabs along the slowest dimension
+   * without assembling the full resolution image. slabReaders is an Array of
+   * functions that return a Promise resolving to an itk.js Image slab, in
+   * order. Every slab but the last must be chunkSize[2] thick so the slab
+   * chunks tile the scale. zSize is the total number of slices. */
+  static async buildPyramidFromSlabs(
+    slabReaders,
+    zSize,
+    chunkSize = [64, 64, 64],
+    isLabelImage = false
+  ) {
+    const scaleInfo = []
+    const pyramid = []
+    let imageType = null
+    let readers = slabReaders
+    let levelZSize = zSize
+    let downsample = true
+    while (downsample) {
+      const levelChunks = new Array(readers.length)
+      const nextSlabs = new Array(readers.length)
+      let levelImage = null
+
+      const processSlab = async index => {
+        const slab = await readers[index]()
+        const size = [slab.size[0], slab.size[1], levelZSize]
+        if (index === 0) {
+          // Metadata of the entire scale
+          levelImage = {
+            imageType: slab.imageType,
+            name: slab.name,
+            origin: slab.origin,
+            spacing: slab.spacing,
+            direction: slab.direction,
+            size,
+          }
+        }
+        levelChunks[index] = chunkImage(slab, chunkSize).chunks
+        if (size.reduce((a, c, i) => a || c / chunkSize[i] >= 2.0, false)) {
+          const factors = downsampleFactors(size, chunkSize)
+          const results = await runDownsampleTasks(
+            slab,
+            factors,
+            isLabelImage,
+            1
+          )
+          nextSlabs[index] = results[0].outputs[0].data
+        }
+      }
+
+      // Bound the number of slabs in flight to bound the peak memory
+      for (let start = 0; start < readers.length; start += numberOfWorkers) {
+        const end = Math.min(start + numberOfWorkers, readers.length)
+        const inFlight = []
+        for (let index = start; index < end; index++) {
+          inFlight.push(processSlab(index))
+        }
+        await Promise.all(inFlight)
+      }
+
+      const levelLayout = chunkImageInfo(levelImage, chunkSize)
+      // Without a largest image, the scale metadata is the only record of
+      // the orientation
+      levelLayout.scaleInfo.direction = dimsDirection(
+        levelImage.direction,
+        levelLayout.scaleInfo.dims
+      )
+      levelLayout.scaleInfo.name = levelImage.name
+      scaleInfo.push(levelLayout.scaleInfo)
+      pyramid.push({
+        chunksStride: levelLayout.chunksStride,
+        chunks: [].concat(...levelChunks),
+        largestImage: null,
+      })
+      imageType = imageType || levelImage.imageType
+
+      downsample = levelImage.size.reduce(
+        (a, c, i) => a || c / chunkSize[i] >= 2.0,
+        false
+      )
+      if (downsample) {
+        // Stack the downsampled slabs back to the chunk thickness
+        const groups = []
+        let group = []
+        let groupZSize = 0
+        nextSlabs.forEach(slab => {
+          group.push(slab)
+          groupZSize += slab.size[2]
+          if (groupZSize >= chunkSize[2]) {
+            groups.push(group)
+            group = []
+            groupZSize = 0
+          }
+        })
+        if (group.length > 0) {
+          groups.push(group)
+        }
+        levelZSize = nextSlabs.reduce((a, slab) => a + slab.size[2], 0)
+        readers = groups.map(slabs => async () =>
+          slabs.length === 1 ? slabs[0] : stackImages(slabs)
+        )
+      }
+    }
+
+    return { scaleInfo, imageType, pyramid }
+  }
+
   constructor(pyramid, scaleInfo, imageType, name = 'Image') {
     super(scaleInfo, imageType, name)
     this.pyramid = pyramid
@@ -296,7 +840,7 @@ class InMemoryMultiscaleChunkedImage extends MultiscaleChunkedImage {
     const chunks = this.pyramid[scale].chunks
     for (let i = 0; i < result.length; i++) {
       const cxyzt = cxyztArray[i]
-      result[i] =
+      const chunk =
         chunks[
           cxyzt[0] * strides[0] +
             cxyzt[1] * strides[1] +
@@ -304,12 +848,52 @@ class InMemoryMultiscaleChunkedImage extends MultiscaleChunkedImage {
             cxyzt[3] * strides[3] +
             cxyzt[4] * strides[4]
         ]
+      result[i] = chunk
+    }
+    const quantization = this.pyramid[scale].quantization
+    if (!!quantization) {
+      return result.map(chunk =>
+        dequantize(chunk, quantization, this.pixelArrayType)
+      )
     }
     return result
   }
 
+  // The chunks belong to the pyramid, except dequantized copies
+  chunksTransferable(scale) {
+    return !!this.pyramid[scale].quantization
+  }
+
+  async scaleLabelIndex(scale) {
+    return this.pyramid[scale].labelIndex || null
+  }
+
   async scaleLargestImage(scale) {
-    return this.pyramid[scale].largestImage
+    const quantization = this.pyramid[scale].quantization
+    if (!!this.pyramid[scale].largestImage && !!quantization) {
+      // A rendered scale is stored dequantized in place of the quantized
+      // copy, so it is not held twice
+      const quantized = this.pyramid[scale].largestImage
+      const image = Object.assign({}, quantized, {
+        imageType: this.imageType,
+        data: dequantize(quantized.data, quantization, this.pixelArrayType),
+      })
+      const chunkSize = this.scaleInfo[scale].sizeCXYZTChunks.slice(
+        1,
+        1 + this.imageType.dimension
+      )
+      this.pyramid[scale] = Object.assign({}, this.pyramid[scale], {
+        chunks: chunkImage(image, chunkSize).chunks,
+        largestImage: image,
+        quantization: null,
+      })
+    }
+    const largestImage = this.pyramid[scale].largestImage
+    if (!!largestImage) {
+      return largestImage
+    }
+    // Pyramids built from slabs only keep the chunks
+    return super.scaleLargestImage(scale)
   }
 }
 
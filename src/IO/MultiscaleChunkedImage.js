@@ -48,6 +48,9 @@ class MultiscaleChunkedImage {
     this.pixelArrayType = componentTypeToTypedArray.get(imageType.componentType)
     this.spatialDims = ['x', 'y', 'z'].slice(0, imageType.dimension)
     this.cachedScaleLargestImage = new Map()
+    // World position, per spatial dimension, around which chunk requests
+    // are prioritized. null components are ignored.
+    this.fetchFocus = [null, null, null]
   }
 
   get lowestScale() {
@@ -107,6 +110,13 @@ class MultiscaleChunkedImage {
     return direction
   }
 
+  /* Set the world position of the focus along a spatial dimension, e.g. the
+   * current slice. Derived classes that fetch chunks request the closest
+   * first. */
+  setFetchFocus(dimension, position) {
+    this.fetchFocus[dimension] = position
+  }
+
   /* Return a promise that provides the requested chunk at a given scale and
    * chunk index. */
   async getChunks(scale, cxyztArray) {
@@ -117,6 +127,19 @@ class MultiscaleChunkedImage {
     console.error('Override me in a derived class')
   }
 
+  /* Whether the chunks provided by getChunks at a given scale may be
+   * transferred to a worker, i.e. they are not kept by the image. */
+  chunksTransferable(scale) {
+    return true
+  }
+
+  /* For label images, resolves to a Map from each label to its voxel count,
+   * bounding box and the chunks that contain it at the given scale, or null
+   * when no index is available. */
+  async scaleLabelIndex(scale) {
+    return null
+  }
+
   /* Retrieve the entire image at the given scale. */
   async scaleLargestImage(scale) {
     if (this.cachedScaleLargestImage.has(scale)) {
@@ -162,7 +185,10 @@ class MultiscaleChunkedImage {
 
     const chunks = await this.getChunks(scale, chunkIndices)
     let transferables = []
-    if (!haveSharedArrayBuffer || !chunks.buffer instanceof SharedArrayBuffer) {
+    if (
+      this.chunksTransferable(scale) &&
+      (!haveSharedArrayBuffer || !chunks.buffer instanceof SharedArrayBuffer)
+    ) {
       for (let chunkIndex = 0; chunkIndex < chunks.length; chunkIndex++) {
         transferables.push(chunks[chunkIndex].buffer)
       }
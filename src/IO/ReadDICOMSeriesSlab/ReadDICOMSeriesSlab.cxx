@@ -0,0 +1,222 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageSeriesReader.h"
+#include "itkImageFileWriter.h"
+#include "itkGDCMImageIO.h"
+#include "itkRGBPixel.h"
+#include "gdcmIPPSorter.h"
+#include <fstream>
+#include <map>
+
+// Sort the series by image position. Only the headers are parsed, so the
+// inputs may be truncated before the pixel data.
+int
+SortSlices( int argc, char * argv [] )
+{
+  const char * sortedIndicesFile = argv[2];
+  const std::vector< std::string > fileNames( argv + 3, argv + argc );
+
+  gdcm::IPPSorter sorter;
+  sorter.SetComputeZSpacing( true );
+  sorter.SetZSpacingTolerance( 1e-3 );
+  if ( !sorter.Sort( fileNames ) )
+  {
+    std::cerr << "Error: unable to sort the series by image position" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::map< std::string, size_t > fileIndex;
+  for ( size_t index = 0; index < fileNames.size(); ++index )
+  {
+    fileIndex[fileNames[index]] = index;
+  }
+
+  // First line: slice spacing, 0 when the slices are not evenly spaced.
+  // Following lines: input index of each slice, in order.
+  std::ofstream ostream( sortedIndicesFile );
+  ostream << sorter.GetZSpacing() << "\n";
+  for ( const auto & fileName : sorter.GetFilenames() )
+  {
+    ostream << fileIndex[fileName] << "\n";
+  }
+  ostream.close();
+
+  return EXIT_SUCCESS;
+}
+
+// Read the slab files, argv[4] on, converted to the pixel type of the first
+// file of the series, argv[3], so every slab of a series has the same type.
+template < typename TImage >
+int
+ReadSlab( int argc, char * argv [] )
+{
+  using ImageType = TImage;
+  const char * outputImageFile = argv[2];
+  const std::vector< std::string > fileNames( argv + 4, argv + argc );
+
+  using ReaderType = itk::ImageSeriesReader< ImageType >;
+  auto reader = ReaderType::New();
+  reader->SetImageIO( itk::GDCMImageIO::New() );
+  reader->SetFileNames( fileNames );
+
+  using WriterType = itk::ImageFileWriter< ImageType >;
+  auto writer = WriterType::New();
+  writer->SetFileName( outputImageFile );
+  writer->SetInput( reader->GetOutput() );
+
+  try
+  {
+    writer->Update();
+  }
+  catch( std::exception & error )
+  {
+    std::cerr << "Error: " << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+template < typename TComponent >
+int
+PixelTypeReadSlab( const itk::IOPixelEnum pixelType, int argc, char * argv[] )
+{
+  using ComponentType = TComponent;
+  constexpr unsigned int Dimension = 3;
+
+  switch (pixelType)
+  {
+    case itk::IOPixelEnum::SCALAR:
+    {
+      using PixelType = ComponentType;
+      using ImageType = itk::Image<PixelType, Dimension>;
+      return ReadSlab<ImageType>( argc, argv );
+    }
+    case itk::IOPixelEnum::RGB:
+    {
+      using PixelType = itk::RGBPixel< ComponentType >;
+      using ImageType = itk::Image<PixelType, Dimension>;
+      return ReadSlab<ImageType>( argc, argv );
+    }
+    case itk::IOPixelEnum::UNKNOWNPIXELTYPE:
+    default:
+      std::cerr << "Unknown or unsupported pixel type: " << pixelType << std::endl;
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+int
+ComponentTypeReadSlab( const itk::IOPixelEnum pixelType, const itk::IOComponentEnum componentType, int argc, char * argv[] )
+{
+  switch (componentType)
+  {
+    case itk::IOComponentEnum::UCHAR:
+    {
+      using ComponentType = unsigned char;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::CHAR:
+    {
+      using ComponentType = char;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::USHORT:
+    {
+      using ComponentType = unsigned short;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::SHORT:
+    {
+      using ComponentType = short;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::UINT:
+    {
+      using ComponentType = unsigned int;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::INT:
+    {
+      using ComponentType = int;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::FLOAT:
+    {
+      using ComponentType = float;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::DOUBLE:
+    {
+      using ComponentType = double;
+      return PixelTypeReadSlab<ComponentType>( pixelType, argc, argv );
+    }
+
+    case itk::IOComponentEnum::UNKNOWNCOMPONENTTYPE:
+    default:
+      std::cerr << "Unknown and unsupported component type: " << componentType << std::endl;
+      return EXIT_FAILURE;
+
+  }
+  return EXIT_SUCCESS;
+}
+
+int main( int argc, char * argv[] )
+{
+  if( argc < 4 )
+    {
+    std::cerr << "Usage: " << argv[0] << " 0 <sortedIndicesFile> <file0> [<file1> ...]" << std::endl;
+    std::cerr << "       " << argv[0] << " 1 <outputImage> <seriesFirstFile> <file0> [<file1> ...]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const unsigned int readSlab = atoi( argv[1] );
+  if ( !readSlab )
+    {
+    return SortSlices( argc, argv );
+    }
+  if( argc < 5 )
+    {
+    std::cerr << "Error: no slab files given" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The first file of the series, which may not be in this slab, describes
+  // the pixel type of every slab. Slices with a different rescale slope or
+  // intercept are converted to it.
+  const char * firstFile = argv[3];
+  itk::GDCMImageIO::Pointer imageIO = itk::GDCMImageIO::New();
+  imageIO->SetFileName( firstFile );
+  try
+    {
+    imageIO->ReadImageInformation();
+    }
+  catch( std::exception & error )
+    {
+    std::cerr << "Error: " << error.what() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return ComponentTypeReadSlab( imageIO->GetPixelType(), imageIO->GetComponentType(), argc, argv );
+}
@@ -7,6 +7,7 @@ import FloatTypes from 'itk/FloatTypes'
 import MultiscaleChunkedImage from './MultiscaleChunkedImage'
 import bloscZarrDecompress from '../Compression/bloscZarrDecompress'
 import CoordsDecompressor from '../Compression/CoordsDecompressor'
+import { chunkFetchScheduler } from './ChunkFetchScheduler'
 
 const dtypeToComponentType = new Map([
   ['<b', IntTypes.Int8],
@@ -190,31 +191,76 @@ class ZarrMultiscaleChunkedImage extends MultiscaleChunkedImage {
     this.CXYZT = ['c', 'x', 'y', 'z', 't']
   }
 
+  setFetchFocus(dimension, position) {
+    super.setFetchFocus(dimension, position)
+    chunkFetchScheduler.reprioritize()
+  }
+
   async getChunksImpl(scale, cxyztArray) {
+    // Requests for another scale of this image are stale
+    chunkFetchScheduler.cancel(
+      tags => tags.image === this && tags.scale !== scale
+    )
+
     const info = this.scaleInfo[scale]
     const chunkPathBase = info.pixelArrayPath
-    const chunkPaths = []
+    const origin = await this.scaleOrigin(scale)
+    const spacing = await this.scaleSpacing(scale)
+    // The fetch focus is a world position, so chunk centers are mapped
+    // through the direction
+    const direction = this.direction
     const chunkPromises = []
     for (let index = 0; index < cxyztArray.length; index++) {
+      const cxyzt = cxyztArray[index]
       let chunkPath = `${chunkPathBase}/`
       for (let dd = 0; dd < info.dims.length; dd++) {
         const dim = info.dims[dd]
-        chunkPath = `${chunkPath}${cxyztArray[index][this.CXYZT.indexOf(dim)]}.`
+        chunkPath = `${chunkPath}${cxyzt[this.CXYZT.indexOf(dim)]}.`
       }
       chunkPath = chunkPath.slice(0, -1)
-      chunkPaths.push(chunkPath)
-      chunkPromises.push(this.store.getItem(chunkPath))
-    }
-    const compressedChunks = await Promise.all(chunkPromises)
-    const toDecompress = []
-    for (let index = 0; index < compressedChunks.length; index++) {
-      toDecompress.push({
-        data: compressedChunks[index],
-        metadata: info.pixelArrayMetadata,
+
+      const chunkOffset = this.spatialDims.map((dim, d) => {
+        const chunkSize = info.sizeCXYZTChunks[d + 1]
+        return (cxyzt[d + 1] + 0.5) * chunkSize * spacing[d]
+      })
+      const chunkCenter = this.spatialDims.map((dim, d) => {
+        let center = origin[d]
+        for (let e = 0; e < chunkOffset.length; e++) {
+          center += direction.getElement(d, e) * chunkOffset[e]
+        }
+        return center
       })
+      const priority = () => {
+        let distance = 0.0
+        for (let d = 0; d < chunkCenter.length; d++) {
+          if (this.fetchFocus[d] !== null) {
+            distance += Math.pow(chunkCenter[d] - this.fetchFocus[d], 2)
+          }
+        }
+        return distance
+      }
+
+      const fetchAndDecompress = async cancelToken => {
+        const compressedChunk = await this.store.getItem(chunkPath, cancelToken)
+        const decompressedChunks = await bloscZarrDecompress([
+          {
+            data: compressedChunk,
+            metadata: info.pixelArrayMetadata,
+          },
+        ])
+        cancelToken.throwIfRequested()
+        return decompressedChunks[0]
+      }
+
+      chunkPromises.push(
+        chunkFetchScheduler.schedule(fetchAndDecompress, priority, {
+          image: this,
+          scale,
+        })
+      )
     }
 
-    return bloscZarrDecompress(toDecompress)
+    return Promise.all(chunkPromises)
   }
 }
 
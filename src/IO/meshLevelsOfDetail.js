@@ -0,0 +1,354 @@
+import WorkerPool from 'itk/WorkerPool'
+import runPipelineBrowser from 'itk/runPipelineBrowser'
+import IOTypes from 'itk/IOTypes'
+import IntTypes from 'itk/IntTypes'
+import FloatTypes from 'itk/FloatTypes'
+import PixelTypes from 'itk/PixelTypes'
+import Mesh from 'itk/Mesh'
+import MeshType from 'itk/MeshType'
+import vtk from 'vtk.js/Sources/vtk'
+
+import pipelineAvailable from './pipelineAvailable'
+
+// Meshes with fewer cells than this are rendered directly
+export const meshLevelOfDetailThreshold = 2e6
+// Each coarser level has this factor fewer faces than the next finer level
+const levelReductionFactor = 4
+// Do not decimate below this number of faces
+const minimumLevelFaces = 1e5
+const maximumNumberOfLevels = 3
+// Upper bound on the triangles of a chunk, which are decimated in one wasm
+// heap
+const maximumChunkTriangles = 1e6
+
+// itk CellGeometry types that are split into triangles
+const triangleCell = 2
+const quadrilateralCell = 3
+const polygonCell = 4
+
+const numberOfWorkers = navigator.hardwareConcurrency
+  ? navigator.hardwareConcurrency
+  : 4
+const decimateWorkerPool = new WorkerPool(numberOfWorkers, runPipelineBrowser)
+
+// Calls callback(a, b, c) with the point ids of every triangle of the
+// surface cells, fan triangulating quadrilaterals and polygons
+function forEachTriangle(mesh, callback) {
+  const cells = mesh.cells
+  let offset = 0
+  for (let cell = 0; cell < mesh.numberOfCells; cell++) {
+    const cellType = cells[offset]
+    const numberOfCellPoints = cells[offset + 1]
+    const ids = offset + 2
+    if (
+      numberOfCellPoints >= 3 &&
+      (cellType === triangleCell ||
+        cellType === quadrilateralCell ||
+        cellType === polygonCell)
+    ) {
+      for (let p = 1; p < numberOfCellPoints - 1; p++) {
+        callback(cells[ids], cells[ids + p], cells[ids + p + 1])
+      }
+    }
+    offset = ids + numberOfCellPoints
+  }
+}
+
+/* Split the triangles of the mesh into a grid of spatial chunks by their
+ * centroid. Points used by more than one chunk are seam points. Each chunk
+ * is an itk.js Mesh whose first numberOfLockedPoints points are its seam
+ * points, with their mesh point ids in lockedPointIds. Point and cell data
+ * are not carried over. */
+function partitionMesh(mesh, numberOfChunks) {
+  const points = mesh.points
+  const numberOfPoints = mesh.numberOfPoints
+  const bounds = [
+    Infinity,
+    -Infinity,
+    Infinity,
+    -Infinity,
+    Infinity,
+    -Infinity,
+  ]
+  for (let p = 0; p < numberOfPoints; p++) {
+    for (let d = 0; d < 3; d++) {
+      const value = points[3 * p + d]
+      bounds[2 * d] = Math.min(bounds[2 * d], value)
+      bounds[2 * d + 1] = Math.max(bounds[2 * d + 1], value)
+    }
+  }
+  // Grid dimensions proportional to the extent along each axis
+  const extent = [0, 1, 2].map(d =>
+    Math.max(bounds[2 * d + 1] - bounds[2 * d], Number.EPSILON)
+  )
+  const unit = Math.cbrt((extent[0] * extent[1] * extent[2]) / numberOfChunks)
+  const gridSize = extent.map(e => Math.max(1, Math.round(e / unit)))
+  const gridChunks = gridSize[0] * gridSize[1] * gridSize[2]
+  const chunkOf = (a, b, c) => {
+    let chunk = 0
+    for (let d = 2; d >= 0; d--) {
+      const centroid =
+        (points[3 * a + d] + points[3 * b + d] + points[3 * c + d]) / 3
+      const index = Math.min(
+        gridSize[d] - 1,
+        Math.floor(((centroid - bounds[2 * d]) / extent[d]) * gridSize[d])
+      )
+      chunk = chunk * gridSize[d] + index
+    }
+    return chunk
+  }
+
+  // -1: unused, -2: seam, otherwise the only chunk that uses the point
+  const pointChunk = new Int32Array(numberOfPoints).fill(-1)
+  const chunkTriangles = new Uint32Array(gridChunks)
+  forEachTriangle(mesh, (a, b, c) => {
+    const chunk = chunkOf(a, b, c)
+    chunkTriangles[chunk]++
+    ;[a, b, c].forEach(p => {
+      if (pointChunk[p] === -1) {
+        pointChunk[p] = chunk
+      } else if (pointChunk[p] !== chunk) {
+        pointChunk[p] = -2
+      }
+    })
+  })
+  const triangles = Array.from(
+    chunkTriangles,
+    count => new Uint32Array(3 * count)
+  )
+  const filled = new Uint32Array(gridChunks)
+  forEachTriangle(mesh, (a, b, c) => {
+    const chunk = chunkOf(a, b, c)
+    const offset = 3 * filled[chunk]++
+    triangles[chunk][offset] = a
+    triangles[chunk][offset + 1] = b
+    triangles[chunk][offset + 2] = c
+  })
+
+  const chunkMeshType = new MeshType(
+    3,
+    FloatTypes.Float32,
+    FloatTypes.Float32,
+    PixelTypes.Scalar,
+    1,
+    IntTypes.UInt32,
+    FloatTypes.Float32,
+    PixelTypes.Scalar,
+    1
+  )
+  const localId = new Int32Array(numberOfPoints).fill(-1)
+  const chunks = []
+  triangles.forEach(chunkIds => {
+    if (chunkIds.length === 0) {
+      return
+    }
+    // Seam points first, so they are the locked points of the chunk
+    const chunkPointIds = []
+    const addPoints = seam => {
+      chunkIds.forEach(p => {
+        if (localId[p] === -1 && (pointChunk[p] === -2) === seam) {
+          localId[p] = chunkPointIds.length
+          chunkPointIds.push(p)
+        }
+      })
+    }
+    addPoints(true)
+    const numberOfLockedPoints = chunkPointIds.length
+    addPoints(false)
+    const chunkPoints = new Float32Array(3 * chunkPointIds.length)
+    chunkPointIds.forEach((p, index) => {
+      chunkPoints[3 * index] = points[3 * p]
+      chunkPoints[3 * index + 1] = points[3 * p + 1]
+      chunkPoints[3 * index + 2] = points[3 * p + 2]
+    })
+    const numberOfTriangles = chunkIds.length / 3
+    const chunkCells = new Uint32Array(5 * numberOfTriangles)
+    for (let t = 0; t < numberOfTriangles; t++) {
+      chunkCells[5 * t] = triangleCell
+      chunkCells[5 * t + 1] = 3
+      chunkCells[5 * t + 2] = localId[chunkIds[3 * t]]
+      chunkCells[5 * t + 3] = localId[chunkIds[3 * t + 1]]
+      chunkCells[5 * t + 4] = localId[chunkIds[3 * t + 2]]
+    }
+    chunkPointIds.forEach(p => {
+      localId[p] = -1
+    })
+
+    const chunkMesh = new Mesh(chunkMeshType)
+    chunkMesh.numberOfPoints = chunkPointIds.length
+    chunkMesh.points = chunkPoints
+    chunkMesh.numberOfCells = numberOfTriangles
+    chunkMesh.cells = chunkCells
+    chunkMesh.cellBufferSize = chunkCells.length
+    chunks.push({
+      mesh: chunkMesh,
+      numberOfLockedPoints,
+      lockedPointIds: Uint32Array.from(
+        chunkPointIds.slice(0, numberOfLockedPoints)
+      ),
+    })
+  })
+  return { chunks, numberOfPoints }
+}
+
+// Pipeline inputs are transferred to the worker. The chunk buffers are
+// copied for every level but the last, which takes them.
+function decimateChunks(chunks, fraction, lastLevel) {
+  const tasks = chunks.map(({ mesh, numberOfLockedPoints }) => {
+    const input = lastLevel
+      ? mesh
+      : Object.assign({}, mesh, {
+          points: mesh.points.slice(),
+          cells: mesh.cells.slice(),
+        })
+    const faces = Math.max(1, Math.floor(mesh.numberOfCells * fraction))
+    const args = [
+      'mesh.json',
+      'decimated.json',
+      '' + faces,
+      '' + numberOfLockedPoints,
+    ]
+    return [
+      'DecimateMesh',
+      args,
+      [{ path: args[1], type: IOTypes.Mesh }],
+      [{ path: args[0], type: IOTypes.Mesh, data: input }],
+    ]
+  })
+  return decimateWorkerPool.runTasks(tasks).promise
+}
+
+// Join the decimated chunks along their locked seam points into vtkPolyData
+function mergeChunks(chunks, results, numberOfPoints) {
+  const decimated = results.map(({ outputs }) => outputs[0].data)
+  // The seam points come first, then the other points of every chunk
+  const seamIndex = new Int32Array(numberOfPoints).fill(-1)
+  let numberOfSeamPoints = 0
+  let mergedPoints = 0
+  let polysSize = 0
+  chunks.forEach(({ lockedPointIds }, c) => {
+    lockedPointIds.forEach(p => {
+      if (seamIndex[p] === -1) {
+        seamIndex[p] = numberOfSeamPoints++
+      }
+    })
+    mergedPoints += decimated[c].numberOfPoints - lockedPointIds.length
+    polysSize += decimated[c].cells.length - decimated[c].numberOfCells
+  })
+  mergedPoints += numberOfSeamPoints
+
+  const points = new Float32Array(3 * mergedPoints)
+  const polys = new Uint32Array(polysSize)
+  let nextPoint = numberOfSeamPoints
+  let polysOffset = 0
+  chunks.forEach(({ lockedPointIds }, c) => {
+    const chunk = decimated[c]
+    const pointIndex = new Uint32Array(chunk.numberOfPoints)
+    for (let p = 0; p < chunk.numberOfPoints; p++) {
+      pointIndex[p] =
+        p < lockedPointIds.length ? seamIndex[lockedPointIds[p]] : nextPoint++
+      points.set(chunk.points.subarray(3 * p, 3 * p + 3), 3 * pointIndex[p])
+    }
+    let offset = 0
+    for (let cell = 0; cell < chunk.numberOfCells; cell++) {
+      const numberOfCellPoints = chunk.cells[offset + 1]
+      polys[polysOffset++] = numberOfCellPoints
+      for (let p = 0; p < numberOfCellPoints; p++) {
+        polys[polysOffset++] = pointIndex[chunk.cells[offset + 2 + p]]
+      }
+      offset += 2 + numberOfCellPoints
+    }
+  })
+
+  return vtk({
+    vtkClass: 'vtkPolyData',
+    points: {
+      vtkClass: 'vtkPoints',
+      name: '_points',
+      numberOfComponents: 3,
+      dataType: 'Float32Array',
+      size: points.length,
+      values: points,
+    },
+    polys: {
+      vtkClass: 'vtkCellArray',
+      name: '_polys',
+      numberOfComponents: 1,
+      dataType: 'Uint32Array',
+      size: polys.length,
+      values: polys,
+    },
+  })
+}
+
+/**
+ * Input:
+ *
+ *   mesh: an itk.js Mesh. Its buffers are copied into chunks before the
+ *     returned Promise resolves, so they can be transferred after that.
+ *
+ * Output:
+ *
+ *   A Promise of an Array of Promises that resolve to vtkPolyData, ordered
+ *   from the coarsest to the finest decimated level; the full resolution
+ *   mesh is not included. The coarsest level is decimated first, then the
+ *   finer ones. The Array is empty for meshes below
+ *   meshLevelOfDetailThreshold, and when the DecimateMesh pipeline is not
+ *   deployed.
+ *
+ * The mesh triangles are split into spatial chunks of at most
+ * maximumChunkTriangles, which are decimated in parallel with the points
+ * they share locked, and joined along those seams. The levels only carry
+ * geometry. The chunks hold a copy of the mesh triangles and points until
+ * the finest level is decimated. Each decimation only needs its chunk in a
+ * wasm heap, so the input size is bounded by reading the mesh and its full
+ * resolution conversion, not by the decimation.
+ */
+async function meshLevelsOfDetail(mesh) {
+  const levelFaces = []
+  if (mesh.numberOfCells < meshLevelOfDetailThreshold) {
+    return levelFaces
+  }
+  let numberOfFaces = Math.floor(mesh.numberOfCells / levelReductionFactor)
+  while (
+    numberOfFaces >= minimumLevelFaces &&
+    levelFaces.length < maximumNumberOfLevels
+  ) {
+    levelFaces.unshift(numberOfFaces)
+    numberOfFaces = Math.floor(numberOfFaces / levelReductionFactor)
+  }
+  if (levelFaces.length === 0) {
+    return levelFaces
+  }
+
+  if (!(await pipelineAvailable('DecimateMesh'))) {
+    return []
+  }
+  const numberOfChunks = Math.max(
+    numberOfWorkers,
+    Math.ceil(mesh.numberOfCells / maximumChunkTriangles)
+  )
+  const { chunks, numberOfPoints } = partitionMesh(mesh, numberOfChunks)
+  const numberOfTriangles = chunks.reduce(
+    (total, { mesh }) => total + mesh.numberOfCells,
+    0
+  )
+
+  const levels = []
+  let previous = Promise.resolve()
+  levelFaces.forEach((faces, level) => {
+    const fraction = faces / numberOfTriangles
+    const lastLevel = level === levelFaces.length - 1
+    // One level at a time, so the coarsest has every worker
+    const decimated = previous.then(() =>
+      decimateChunks(chunks, fraction, lastLevel)
+    )
+    previous = decimated.catch(() => null)
+    levels.push(
+      decimated.then(results => mergeChunks(chunks, results, numberOfPoints))
+    )
+  })
+  return levels
+}
+
+export default meshLevelsOfDetail
@@ -0,0 +1,23 @@
+import axios from 'axios'
+import itkConfig from 'itk/itkConfig'
+
+const availablePipelines = new Map()
+
+// Resolves to whether the wasm module of an itk.js pipeline is deployed
+// with the viewer, without fetching or compiling it. The answer is kept for
+// the session.
+function pipelineAvailable(pipelinePath) {
+  if (!availablePipelines.has(pipelinePath)) {
+    const moduleUrl = `${itkConfig.itkModulesPath}/Pipelines/${pipelinePath}Wasm.js`
+    availablePipelines.set(
+      pipelinePath,
+      axios.head(moduleUrl).then(
+        () => true,
+        () => false
+      )
+    )
+  }
+  return availablePipelines.get(pipelinePath)
+}
+
+export default pipelineAvailable
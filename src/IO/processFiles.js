@@ -17,6 +17,11 @@ import vtkITKHelper from 'vtk.js/Sources/Common/DataModel/ITKHelper'
 
 import UserInterface from '../UserInterface'
 import createViewer from '../createViewer'
+import meshLevelsOfDetail from './meshLevelsOfDetail'
+import pipelineAvailable from './pipelineAvailable'
+import readImageDICOMFileSeriesChunked, {
+  chunkedDICOMSeriesMinimumSlices,
+} from './readImageDICOMFileSeriesChunked'
 
 function typedArrayForBuffer(typedArrayType, buffer) {
   let typedArrayFunction = null
@@ -34,7 +39,7 @@ export const processFiles = async (
   { files, image, labelImage, config, labelImageNames, rotate, use2D }
 ) => {
   UserInterface.emptyContainer(container)
-  UserInterface.createLoadingProgress(container)
+  const progressCallback = UserInterface.createLoadingProgress(container)
   const viewerConfig = await readFiles({
     files,
     image,
@@ -44,7 +49,52 @@ export const processFiles = async (
   })
   viewerConfig.config = config
   viewerConfig.rotate = rotate
-  return createViewer(container, viewerConfig)
+  viewerConfig.progressCallback = progressCallback
+  const viewer = await createViewer(container, viewerConfig)
+  applyGeometryLevelsOfDetail(viewer, viewerConfig)
+  return viewer
+}
+
+// Swap in finer geometry levels of detail as they finish decimating
+function applyGeometryLevelsOfDetail(viewer, viewerConfig) {
+  const { geometries, geometryLevelsOfDetail } = viewerConfig
+  if (!!!geometryLevelsOfDetail) {
+    return
+  }
+  const currentGeometries = geometries.slice()
+  geometryLevelsOfDetail.forEach((levels, index) => {
+    let appliedLevel = -1
+    levels.forEach((levelPromise, level) => {
+      levelPromise.then(
+        polyData => {
+          if (level > appliedLevel) {
+            appliedLevel = level
+            currentGeometries[index] = polyData
+            viewer.setGeometries(currentGeometries.slice())
+          }
+        },
+        error => {
+          // The geometry that is shown is kept
+          console.error(error)
+        }
+      )
+    })
+  })
+}
+
+// Resolves with the index and value of the first Promise, in order, that
+// fulfills, or rejects when all of them reject
+async function firstFulfilledInOrder(promises) {
+  let lastError = null
+  for (let index = 0; index < promises.length; index++) {
+    try {
+      const value = await promises[index]
+      return { index, value }
+    } catch (error) {
+      lastError = error
+    }
+  }
+  throw lastError
 }
 
 export const readFiles = async ({
@@ -60,6 +110,16 @@ export const readFiles = async ({
     readDICOMSeries = function() {
       return Promise.reject('Skip DICOM series read attempt')
     }
+  } else if (files.length >= chunkedDICOMSeriesMinimumSlices) {
+    readDICOMSeries = async function(seriesFiles) {
+      // Only with its pipeline deployed, so a missing module costs no reads
+      if (!(await pipelineAvailable('ReadDICOMSeriesSlab'))) {
+        return readImageDICOMFileSeries(seriesFiles)
+      }
+      return readImageDICOMFileSeriesChunked(seriesFiles).catch(() =>
+        readImageDICOMFileSeries(seriesFiles)
+      )
+    }
   }
   try {
     const { image: itkImage, webWorkerPool } = await readDICOMSeries(files)
@@ -95,15 +155,17 @@ export const readFiles = async ({
       } else if (extensionToMeshIO.has(extension)) {
         let is3D = true
         const read0 = performance.now()
-        let convert0 = null
         return readMeshFile(null, file)
-          .then(({ mesh: itkMesh, webWorker }) => {
+          .then(async ({ mesh: itkMesh, webWorker }) => {
             const read1 = performance.now()
             const duration = Number(read1 - read0)
               .toFixed(1)
               .toString()
             console.log('Mesh reading took ' + duration + ' milliseconds.')
             webWorker.terminate()
+            // Copies the mesh into chunks, so wait before its buffers are
+            // transferred for the full resolution conversion
+            const levelsOfDetail = await meshLevelsOfDetail(itkMesh)
             const pipelinePath = 'MeshToPolyData'
             const args = ['mesh.json', 'polyData.json']
             const desiredOutputs = [
@@ -113,23 +175,42 @@ export const readFiles = async ({
               { path: args[0], type: IOTypes.Mesh, data: itkMesh },
             ]
             is3D = itkMesh.meshType.dimension === 3
-            convert0 = performance.now()
-            return runPipelineBrowser(
+            const convert0 = performance.now()
+            const fullResolution = runPipelineBrowser(
               null,
               pipelinePath,
               args,
               desiredOutputs,
               inputs
-            )
-          })
-          .then(function({ outputs, webWorker }) {
-            const convert1 = performance.now()
-            const duration = Number(convert1 - convert0)
-              .toFixed(1)
-              .toString()
-            console.log('Mesh conversion took ' + duration + ' milliseconds.')
-            webWorker.terminate()
-            return Promise.resolve({ is3D, data: vtk(outputs[0].data) })
+            ).then(function({ outputs, webWorker }) {
+              const convert1 = performance.now()
+              const duration = Number(convert1 - convert0)
+                .toFixed(1)
+                .toString()
+              console.log(
+                'Mesh conversion took ' + duration + ' milliseconds.'
+              )
+              webWorker.terminate()
+              return vtk(outputs[0].data)
+            })
+            if (levelsOfDetail.length === 0) {
+              return fullResolution.then(data => {
+                return { is3D, data }
+              })
+            }
+            // Render the coarsest level, then swap in the finer ones. Levels
+            // that fail to decimate are skipped.
+            const levels = levelsOfDetail.concat([fullResolution])
+            // Finer levels may fail while a coarser one is awaited; their
+            // errors are handled once they are applied
+            levels.forEach(level => level.catch(() => null))
+            return firstFulfilledInOrder(levels).then(({ index, value }) => {
+              return {
+                is3D,
+                data: value,
+                levelsOfDetail: levels.slice(index + 1),
+              }
+            })
           })
           .catch(error => {
             return readImageFile(null, file)
@@ -187,20 +268,25 @@ export const readFiles = async ({
         }
       }
     }
-    const geometries = dataSets
-      .filter(({ data }) => {
-        return (
-          !!data &&
-          data.isA !== undefined &&
-          data.isA('vtkPolyData') &&
-          !!(
-            data.getPolys().getNumberOfValues() ||
-            data.getLines().getNumberOfValues() ||
-            data.getStrips().getNumberOfValues()
-          )
+    const geometryDataSets = dataSets.filter(({ data }) => {
+      return (
+        !!data &&
+        data.isA !== undefined &&
+        data.isA('vtkPolyData') &&
+        !!(
+          data.getPolys().getNumberOfValues() ||
+          data.getLines().getNumberOfValues() ||
+          data.getStrips().getNumberOfValues()
         )
-      })
-      .map(({ data }) => data)
+      )
+    })
+    const geometries = geometryDataSets.map(({ data }) => data)
+    let geometryLevelsOfDetail = null
+    if (geometryDataSets.some(({ levelsOfDetail }) => !!levelsOfDetail)) {
+      geometryLevelsOfDetail = geometryDataSets.map(
+        ({ levelsOfDetail }) => levelsOfDetail || []
+      )
+    }
     const pointSets = dataSets
       .filter(({ data }) => {
         return (
@@ -224,6 +310,7 @@ export const readFiles = async ({
       labelImage,
       labelImageNames: labelImageNameData,
       geometries,
+      geometryLevelsOfDetail,
       pointSets,
       use2D: use2D || !any3D,
     }
@@ -0,0 +1,113 @@
+import WorkerPool from 'itk/WorkerPool'
+import runPipelineBrowser from 'itk/runPipelineBrowser'
+import IOTypes from 'itk/IOTypes'
+import PromiseFileReader from 'promise-file-reader'
+
+import InMemoryMultiscaleChunkedImage from './InMemoryMultiscaleChunkedImage'
+
+// Series with fewer slices are read with readImageDICOMFileSeries
+export const chunkedDICOMSeriesMinimumSlices = 256
+// The slice position and orientation precede the pixel data, so only the
+// start of each file is needed to sort the series
+const headerBytes = 65536
+
+const numberOfWorkers = navigator.hardwareConcurrency
+  ? navigator.hardwareConcurrency
+  : 4
+const dicomWorkerPool = new WorkerPool(numberOfWorkers, runPipelineBrowser)
+
+const pipelinePath = 'ReadDICOMSeriesSlab'
+
+async function sortSlices(files) {
+  const headers = await Promise.all(
+    files.map(file =>
+      PromiseFileReader.readAsArrayBuffer(file.slice(0, headerBytes))
+    )
+  )
+  const inputs = headers.map((header, index) => {
+    return {
+      path: `${index}.dcm`,
+      type: IOTypes.Binary,
+      data: new Uint8Array(header),
+    }
+  })
+  const args = ['0', 'sortedIndices.txt'].concat(inputs.map(i => i.path))
+  const desiredOutputs = [{ path: 'sortedIndices.txt', type: IOTypes.Text }]
+  const results = await dicomWorkerPool.runTasks([
+    [pipelinePath, args, desiredOutputs, inputs],
+  ]).promise
+  const lines = results[0].outputs[0].data.trim().split('\n')
+  const zSpacing = parseFloat(lines[0])
+  const sortedFiles = lines.slice(1).map(index => files[parseInt(index)])
+  return { zSpacing, sortedFiles }
+}
+
+// The first file of the series sets the pixel type of every slab
+async function readSlab(slabFiles, seriesFirstFile, zSpacing) {
+  const contents = await Promise.all(
+    [seriesFirstFile]
+      .concat(slabFiles)
+      .map(file => PromiseFileReader.readAsArrayBuffer(file))
+  )
+  const inputs = contents.map((content, index) => {
+    return {
+      path: `${index}.dcm`,
+      type: IOTypes.Binary,
+      data: new Uint8Array(content),
+    }
+  })
+  // The series file is followed by the slab files
+  const args = ['1', 'slab.json'].concat(inputs.map(i => i.path))
+  const desiredOutputs = [{ path: 'slab.json', type: IOTypes.Image }]
+  const results = await dicomWorkerPool.runTasks([
+    [pipelinePath, args, desiredOutputs, inputs],
+  ]).promise
+  const slab = results[0].outputs[0].data
+  // A slab's own spacing is unreliable when it holds a single slice
+  if (zSpacing > 0.0) {
+    slab.spacing[2] = zSpacing
+  }
+  return slab
+}
+
+/**
+ * Read a DICOM series into an InMemoryMultiscaleChunkedImage.
+ *
+ * Slabs of slices are decoded in parallel and written directly into the
+ * chunks, then downsampled slab by slab into the pyramid, so the full
+ * resolution volume is never assembled.
+ *
+ * Resolves to { image, webWorkerPool } like readImageDICOMFileSeries.
+ */
+async function readImageDICOMFileSeriesChunked(
+  files,
+  chunkSize = [64, 64, 64]
+) {
+  const { zSpacing, sortedFiles } = await sortSlices(Array.from(files))
+
+  const slabReaders = []
+  for (let start = 0; start < sortedFiles.length; start += chunkSize[2]) {
+    const slabFiles = sortedFiles.slice(start, start + chunkSize[2])
+    slabReaders.push(() => readSlab(slabFiles, sortedFiles[0], zSpacing))
+  }
+
+  const {
+    scaleInfo,
+    imageType,
+    pyramid,
+  } = await InMemoryMultiscaleChunkedImage.buildPyramidFromSlabs(
+    slabReaders,
+    sortedFiles.length,
+    chunkSize
+  )
+  const image = new InMemoryMultiscaleChunkedImage(
+    pyramid,
+    scaleInfo,
+    imageType,
+    sortedFiles[0].name
+  )
+
+  return { image, webWorkerPool: dicomWorkerPool }
+}
+
+export default readImageDICOMFileSeriesChunked
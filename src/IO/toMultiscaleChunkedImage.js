@@ -1,4 +1,5 @@
 import axios from 'axios'
+import IntTypes from 'itk/IntTypes'
 import readImageArrayBuffer from 'itk/readImageArrayBuffer'
 
 import getFileExtension from 'itk/getFileExtension'
@@ -8,7 +9,20 @@ import InMemoryMultiscaleChunkedImage from './InMemoryMultiscaleChunkedImage'
 import ZarrMultiscaleChunkedImage from './ZarrMultiscaleChunkedImage'
 import ndarrayToItkImage from './ndarrayToItkImage'
 
-async function itkImageToInMemoryMultiscaleChunkedImage(image, isLabelImage) {
+// With quantizeCoarseScales, float images keep full precision at scale 0 and
+// are stored with 16 bits from scale 1 on
+const coarseScaleQuantization = {
+  componentType: IntTypes.UInt16,
+  fromScale: 1,
+}
+
+async function itkImageToInMemoryMultiscaleChunkedImage(
+  image,
+  isLabelImage,
+  cancelToken,
+  quantizeCoarseScales,
+  progressCallback
+) {
   let chunkSize = [64, 64, 64]
   if (image.data.length < 2e6) {
     // Keep a single chunk
@@ -24,7 +38,10 @@ async function itkImageToInMemoryMultiscaleChunkedImage(image, isLabelImage) {
   } = await InMemoryMultiscaleChunkedImage.buildPyramid(
     image,
     chunkSize,
-    isLabelImage
+    isLabelImage,
+    quantizeCoarseScales ? coarseScaleQuantization : null,
+    cancelToken,
+    progressCallback
   )
   const multiscaleImage = new InMemoryMultiscaleChunkedImage(
     pyramid,
@@ -36,7 +53,28 @@ async function itkImageToInMemoryMultiscaleChunkedImage(image, isLabelImage) {
   return multiscaleImage
 }
 
-async function toMultiscaleChunkedImage(image, isLabelImage = false) {
+/* Options:
+ *
+ * cancelToken: an optional axios CancelToken. When it is cancelled, the
+ * in-memory pyramid build stops and the Promise rejects with the
+ * axios.Cancel.
+ *
+ * quantizeCoarseScales: store the coarser in-memory scales of float images
+ * quantized to 16 bits, a lossy trade of precision for memory. The shipped
+ * DownsampleWasm predates quantization, so until the Downsample pipelines
+ * are rebuilt, the scales are kept exact after a warning.
+ *
+ * progressCallback: called with { loaded, total } while the in-memory
+ * pyramid is built. */
+async function toMultiscaleChunkedImage(
+  image,
+  isLabelImage = false,
+  {
+    cancelToken = null,
+    quantizeCoarseScales = false,
+    progressCallback = null,
+  } = {}
+) {
   let multiscaleImage = null
   if (image instanceof MultiscaleChunkedImage) {
     // Already a multi-scale, chunked image
@@ -45,14 +83,20 @@ async function toMultiscaleChunkedImage(image, isLabelImage = false) {
     // itk.js Image
     multiscaleImage = await itkImageToInMemoryMultiscaleChunkedImage(
       image,
-      isLabelImage
+      isLabelImage,
+      cancelToken,
+      quantizeCoarseScales,
+      progressCallback
     )
   } else if (image._rtype !== undefined && image._rtype === 'ndarray') {
     // ndarray
     const itkImage = ndarrayToItkImage(image)
     multiscaleImage = await itkImageToInMemoryMultiscaleChunkedImage(
       itkImage,
-      isLabelImage
+      isLabelImage,
+      cancelToken,
+      quantizeCoarseScales,
+      progressCallback
     )
   } else if (image.href !== undefined) {
     const imageHref = image.href
@@ -72,6 +116,7 @@ async function toMultiscaleChunkedImage(image, isLabelImage = false) {
     } else {
       const response = await axios.get(imageHref, {
         responseType: 'arraybuffer',
+        cancelToken,
       })
       const { image: itkImage, webWorker } = await readImageArrayBuffer(
         null,
@@ -81,7 +126,10 @@ async function toMultiscaleChunkedImage(image, isLabelImage = false) {
       webWorker.terminate()
       multiscaleImage = await itkImageToInMemoryMultiscaleChunkedImage(
         itkImage,
-        isLabelImage
+        isLabelImage,
+        cancelToken,
+        quantizeCoarseScales,
+        progressCallback
       )
     }
   } else {
@@ -1,3 +1,4 @@
+import axios from 'axios'
 import vtkITKHelper from 'vtk.js/Sources/Common/DataModel/ITKHelper'
 import vtkDataArray from 'vtk.js/Sources/Common/Core/DataArray'
 
@@ -19,7 +20,7 @@ const createUpdateFusedImageWorker = existingWorker => {
 }
 let updateFusedImageWorker = null
 
-async function updateRenderedImage(context) {
+async function fuseRenderedImage(context) {
   const name = context.images.updateRenderedName
   const actorContext = context.images.actorContext.get(name)
 
@@ -196,4 +197,16 @@ async function updateRenderedImage(context) {
   }
 }
 
+async function updateRenderedImage(context) {
+  try {
+    await fuseRenderedImage(context)
+  } catch (error) {
+    // Requesting another scale of the image cancels the chunk requests of
+    // this one; the newer update renders in its place
+    if (!axios.isCancel(error)) {
+      throw error
+    }
+  }
+}
+
 export default updateRenderedImage
@@ -0,0 +1,12 @@
+// Prioritize chunk requests around the current slice
+function applyChunkFetchFocus(context, dimension, position) {
+  context.images.actorContext.forEach(actorContext => {
+    ;[actorContext.image, actorContext.labelImage].forEach(image => {
+      if (image) {
+        image.setFetchFocus(dimension, position)
+      }
+    })
+  })
+}
+
+export default applyChunkFetchFocus
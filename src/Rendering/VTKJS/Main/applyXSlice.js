@@ -1,5 +1,8 @@
+import applyChunkFetchFocus from './applyChunkFetchFocus'
+
 function applyXSlice(context, event) {
   const position = event.data
+  applyChunkFetchFocus(context, 0, Number(position))
 
   const volumeRep = context.images.representationProxy
   if (volumeRep) {
@@ -1,5 +1,8 @@
+import applyChunkFetchFocus from './applyChunkFetchFocus'
+
 function applyYSlice(context, event) {
   const position = event.data
+  applyChunkFetchFocus(context, 1, Number(position))
 
   const volumeRep = context.images.representationProxy
   if (volumeRep) {
@@ -1,5 +1,8 @@
+import applyChunkFetchFocus from './applyChunkFetchFocus'
+
 function applyZSlice(context, event) {
   const position = event.data
+  applyChunkFetchFocus(context, 2, Number(position))
 
   const volumeRep = context.images.representationProxy
   if (volumeRep) {
@@ -1,3 +1,4 @@
+import axios from 'axios'
 import { inspect } from '@xstate/inspect'
 import { interpret } from 'xstate'
 
@@ -39,8 +40,27 @@ const createViewer = async (
     rotate = true,
     uiContainer,
     config,
+    progressCallback = null,
   }
 ) => {
+  const context = new ViewerMachineContext(config)
+
+  // Build the pyramids before the container is emptied, so a loading
+  // progress in it stays up until they are done
+  let multiscaleImage = null
+  if (!!image) {
+    multiscaleImage = await toMultiscaleChunkedImage(image, false, {
+      quantizeCoarseScales: context.quantizeCoarseScales,
+      progressCallback,
+    })
+  }
+  let multiscaleLabelImage = null
+  if (!!labelImage) {
+    multiscaleLabelImage = await toMultiscaleChunkedImage(labelImage, true, {
+      progressCallback,
+    })
+  }
+
   UserInterface.emptyContainer(rootContainer)
   if (!UserInterface.checkForWebGL(rootContainer)) {
     throw new Error('WebGL could not be loaded.')
@@ -174,7 +194,6 @@ const createViewer = async (
   }
 
   const options = viewerMachineOptions
-  const context = new ViewerMachineContext(config)
   context.use2D = use2D
   context.rootContainer = rootContainer
   // Todo: move to viewer machine
@@ -352,17 +371,12 @@ const createViewer = async (
     }
   )
   let imageName = null
-  if (!!image) {
-    const multiscaleImage = await toMultiscaleChunkedImage(image)
+  if (!!multiscaleImage) {
     imageName = multiscaleImage.name
     service.send({ type: 'ADD_IMAGE', data: multiscaleImage })
   }
 
-  if (!!labelImage) {
-    const multiscaleLabelImage = await toMultiscaleChunkedImage(
-      labelImage,
-      true
-    )
+  if (!!multiscaleLabelImage) {
     if (multiscaleLabelImage.name === 'Image') {
       multiscaleLabelImage.name = 'LabelImage'
     }
@@ -815,11 +829,35 @@ const createViewer = async (
     context.service.send({ type: 'SELECT_LAYER', data: name })
   }
 
+  // Pending multiscale conversions by image name, so a newer image replaces
+  // the stale one without waiting for its pyramid
+  const pendingImageConversions = new Map()
   publicAPI.setImage = async (image, name) => {
     if (typeof name === 'undefined' && context.images.selectedName) {
       name = context.images.selectedName
     }
-    const multiscaleImage = await toMultiscaleChunkedImage(image)
+    if (pendingImageConversions.has(name)) {
+      pendingImageConversions.get(name).cancel('Image replaced')
+    }
+    const cancelSource = axios.CancelToken.source()
+    pendingImageConversions.set(name, cancelSource)
+    let multiscaleImage = null
+    try {
+      multiscaleImage = await toMultiscaleChunkedImage(image, false, {
+        cancelToken: cancelSource.token,
+        quantizeCoarseScales: context.quantizeCoarseScales,
+        progressCallback,
+      })
+    } catch (error) {
+      if (axios.isCancel(error)) {
+        return
+      }
+      throw error
+    } finally {
+      if (pendingImageConversions.get(name) === cancelSource) {
+        pendingImageConversions.delete(name)
+      }
+    }
     multiscaleImage.name = name
     if (context.images.actorContext.has(name)) {
       const actorContext = context.images.actorContext.get(name)
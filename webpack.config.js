@@ -97,6 +97,20 @@ module.exports = [
           from: path.join(__dirname, 'src', 'IO', 'Downsample', 'web-build'),
           to: path.join(__dirname, 'dist', 'itk', 'Pipelines'),
         },
+        {
+          from: path.join(__dirname, 'src', 'IO', 'DecimateMesh', 'web-build'),
+          to: path.join(__dirname, 'dist', 'itk', 'Pipelines'),
+        },
+        {
+          from: path.join(
+            __dirname,
+            'src',
+            'IO',
+            'ReadDICOMSeriesSlab',
+            'web-build'
+          ),
+          to: path.join(__dirname, 'dist', 'itk', 'Pipelines'),
+        },
       ]),
       // workbox plugin should be last plugin
       new GenerateSW({
@@ -143,6 +157,7 @@ module.exports = [
       modules: [path.resolve(__dirname, 'node_modules')],
       alias: {
         './itkConfig$': path.resolve(__dirname, 'src', 'itkConfigCDN.js'),
+        'itk/itkConfig$': path.resolve(__dirname, 'src', 'itkConfigCDN.js'),
       },
       fallback: { fs: false, stream: require.resolve('stream-browserify') },
     },